@@ -0,0 +1,39 @@
+#include <malloc.h>
+
+#include "common.h"
+
+bool allocationTracking = false;
+atomic<size_t> allocationCount{0};
+
+bool heapTracking = false;
+thread_local int64_t threadHeapBytes = 0;
+
+void* operator new(size_t size)
+{
+    if(allocationTracking)
+        allocationCount.fetch_add(1, memory_order_relaxed);
+
+    if(void* ptr = malloc(size ? size : 1))
+    {
+        if(heapTracking)
+            threadHeapBytes += malloc_usable_size(ptr);
+        return ptr;
+    }
+    throw bad_alloc();
+}
+
+// Kept out of line : inlined, GCC sees free() taking what operator
+// new returned and can't tell the two are a pair.
+[[gnu::noinline]] void operator delete(void* ptr) noexcept
+{
+    if(heapTracking && ptr)
+        threadHeapBytes -= malloc_usable_size(ptr);
+    free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void* ptr, size_t) noexcept
+{
+    if(heapTracking && ptr)
+        threadHeapBytes -= malloc_usable_size(ptr);
+    free(ptr);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "entity_store.h"
+#include "flow_field.h"
+
+// What an enemy decided to do this turn.
+struct EnemyAction
+{
+    position target;
+    // Player slot to attack, or -1 to move to target.
+    int32_t player;
+};
+
+// Where an archetype's attack offsets are measured from.
+enum class AttackAnchor {
+    SELF,
+    TARGET,
+};
+
+// Each enemy type is described at compile time: its default stats,
+// the cells its attack covers and how it picks a move. The world
+// keeps one pool per type and runs each type's decide in its own
+// loop, so nothing is virtual and nothing is cast.
+//
+// decide only reads the world, it's called from several threads.
+
+// Blind bats randomly move around the square middle they started
+// at, and hit everything around them when a player gets close.
+struct BlindBatArchetype
+{
+    static constexpr ENEMY_TYPE type = ENEMY_TYPE::BLIND_BAT;
+    static constexpr string_view name = "Blind Bat";
+    static constexpr char sprite = 'B';
+    static constexpr int health  = 30;
+    static constexpr int attack  = 5;
+    static constexpr int defense = 1;
+    static constexpr bool followsPlayers = false;
+
+    static constexpr AttackAnchor anchor = AttackAnchor::SELF;
+    static constexpr char attackSprite = '^';
+    static constexpr array<position, 8> attackOffsets = {{
+        {-1, 0}, {-1, -1}, {1, 1}, {1, 0}, {0, 1}, {-1, 1}, {1, -1}, {0, -1},
+    }};
+
+    template<class WorldView>
+    static void decide(const WorldView& world, const EntityStore& store, size_t slot,
+            EnemyAction& action)
+    {
+        action.player = world.findPlayerSlotNear(store.positions[slot], 1);
+        if(action.player >= 0)
+            return;
+
+        uint64_t bits = world.wanderBits(store.ids[slot]);
+        position squareMiddle = store.homes[slot];
+        action.target = position(squareMiddle.first + static_cast<int>((bits & 0xffffffff) % 3) - 1,
+                squareMiddle.second + static_cast<int>((bits >> 32) % 3) - 1);
+    }
+};
+
+// Hounds follow the world's flow field towards the
+// closest player and bite once they are next to it.
+struct HoundArchetype
+{
+    static constexpr ENEMY_TYPE type = ENEMY_TYPE::HOUND;
+    static constexpr string_view name = "Hound";
+    static constexpr char sprite = 'H';
+    static constexpr int health  = 40;
+    static constexpr int attack  = 8;
+    static constexpr int defense = 2;
+    static constexpr bool followsPlayers = true;
+
+    static constexpr AttackAnchor anchor = AttackAnchor::TARGET;
+    static constexpr char attackSprite = '*';
+    static constexpr array<position, 1> attackOffsets = {{ {0, 0} }};
+
+    template<class WorldView>
+    static void decide(const WorldView& world, const EntityStore& store, size_t slot,
+            EnemyAction& action)
+    {
+        action.player = world.findPlayerSlotNear(store.positions[slot], 1);
+        if(action.player < 0)
+            world.getFlowField().nextStep(store.positions[slot], action.target);
+    }
+};
+
+// In ENEMY_TYPE order, adding a type means adding it here.
+using EnemyArchetypes = tuple<BlindBatArchetype, HoundArchetype>;
+
+static_assert(tuple_size<EnemyArchetypes>::value == ENEMY_TYPE_COUNT, "an enemy type has no archetype");
+static_assert(BlindBatArchetype::type == ENEMY_TYPE::BLIND_BAT && HoundArchetype::type == ENEMY_TYPE::HOUND,
+        "archetypes are out of order");
+
+// Calls visit with a default constructed value of every archetype.
+template<class Visitor>
+void forEachArchetype(Visitor&& visit)
+{
+    apply([&](auto... archetype) { (visit(archetype), ...); }, EnemyArchetypes{});
+}
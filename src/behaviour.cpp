@@ -0,0 +1,75 @@
+#include "world.h"
+
+size_t Actor::slot() const
+{
+    return world_->pools_[static_cast<size_t>(enemyTypeOf(id_))].store.find(id_);
+}
+
+EnemyAction& Actor::action() const
+{
+    return world_->pools_[static_cast<size_t>(enemyTypeOf(id_))].actions[slot()];
+}
+
+FramePool& Actor::getFrames() const
+{
+    return world_->frames_;
+}
+
+// Kept in the promise, which stays put in the frame while the
+// pool's behaviours move around.
+BehaviourState& Actor::getState() const
+{
+    auto& pool = world_->pools_[static_cast<size_t>(enemyTypeOf(id_))];
+    return pool.behaviours[handleIndexOf(id_)].promise().state;
+}
+
+position Actor::getPosition() const
+{
+    return world_->getEnemies(enemyTypeOf(id_)).positions[slot()];
+}
+
+position Actor::getHome() const
+{
+    return world_->getEnemies(enemyTypeOf(id_)).homes[slot()];
+}
+
+int Actor::getHealth() const
+{
+    return world_->getEnemies(enemyTypeOf(id_)).health[slot()];
+}
+
+Player* Actor::findPlayer(int radius) const
+{
+    return world_->findPlayerNear(getPosition(), radius);
+}
+
+bool Actor::attack() const
+{
+    int32_t player = world_->findPlayerSlotNear(getPosition(), 1);
+    if(player >= 0)
+        action().player = player;
+    return player >= 0;
+}
+
+void Actor::stepTowards(position target) const
+{
+    position from = getPosition();
+    int dr = (target.first > from.first) - (target.first < from.first);
+    int dc = (target.second > from.second) - (target.second < from.second);
+
+    // Straight at it first, then either half of the diagonal.
+    for(position step : { position(dr, dc), position(dr, 0), position(0, dc) })
+    {
+        position to(from.first + step.first, from.second + step.second);
+        if(to != from && world_->getTerrain().inside(to) && world_->isPassable(to))
+        {
+            action().target = to;
+            return;
+        }
+    }
+}
+
+bool Actor::followPlayers() const
+{
+    return world_->getFlowField().nextStep(getPosition(), action().target);
+}
@@ -0,0 +1,374 @@
+#pragma once
+
+#include "archetypes.h"
+
+// Coroutine frames of a world's behaviour scripts. Sizes are rounded
+// up to FRAME_GRAIN and released frames go on a free list per size,
+// fed from blocks that are only given back with the pool, so scripts
+// starting and ending every turn don't reach malloc. Frames over
+// MAX_FRAME come from the heap. Not thread safe, scripts are started
+// and ended by whatever runs their world's turn.
+class FramePool
+{
+
+private:
+
+    static constexpr size_t FRAME_GRAIN = 16;
+    static constexpr size_t MAX_FRAME   = 2048;
+    static constexpr size_t BLOCK_SIZE  = 64 * 1024;
+
+    struct FreeFrame
+    {
+        FreeFrame* next;
+    };
+
+    array<FreeFrame*, MAX_FRAME / FRAME_GRAIN> free_{};
+    vector< unique_ptr<char[]> > blocks_;
+    char* cursor_ = nullptr;
+    char* end_ = nullptr;
+
+public:
+
+    FramePool() = default;
+    FramePool(const FramePool&) = delete;
+    FramePool& operator=(const FramePool&) = delete;
+
+    void* allocate(size_t size)
+    {
+        if(size > MAX_FRAME)
+            return ::operator new(size);
+
+        size_t sizeClass = (size - 1) / FRAME_GRAIN;
+        if(FreeFrame* frame = free_[sizeClass])
+        {
+            free_[sizeClass] = frame->next;
+            return frame;
+        }
+
+        size_t rounded = (sizeClass + 1) * FRAME_GRAIN;
+        if(static_cast<size_t>(end_ - cursor_) < rounded)
+        {
+            blocks_.emplace_back(new char[BLOCK_SIZE]);
+            cursor_ = blocks_.back().get();
+            end_    = cursor_ + BLOCK_SIZE;
+        }
+        void* frame = cursor_;
+        cursor_ += rounded;
+        return frame;
+    }
+
+    void release(void* frame, size_t size)
+    {
+        if(size > MAX_FRAME)
+        {
+            ::operator delete(frame);
+            return;
+        }
+
+        size_t sizeClass = (size - 1) / FRAME_GRAIN;
+        auto freed = static_cast<FreeFrame*>(frame);
+        freed->next = free_[sizeClass];
+        free_[sizeClass] = freed;
+    }
+};
+
+// What a suspended behaviour script is waiting for.
+enum class BehaviourWait : uint8_t
+{
+    NONE,       // running, or woken and due this turn
+    TURNS,      // argument more turns
+    PLAYER,     // a player within argument cells
+    HURT,       // the enemy taking damage
+    DONE,       // returned, the archetype takes over again
+};
+
+// What a script keeps from one turn to the next, saved with its
+// enemy. See Behaviour for how scripts use it.
+struct BehaviourState
+{
+    int32_t phase = 0;
+    int32_t turns = 0;
+};
+
+// Links a suspended script into one of its world's wait lists.
+// Lists are rings through a head link that holds no script, so
+// filing, taking out and moving a whole list never allocate. A
+// link takes itself out of its list when its frame goes away.
+struct BehaviourLink
+{
+    BehaviourLink* prev = this;
+    BehaviourLink* next = this;
+
+    BehaviourLink() = default;
+    BehaviourLink(const BehaviourLink&) = delete;
+    BehaviourLink& operator=(const BehaviourLink&) = delete;
+
+    ~BehaviourLink() { unlink(); }
+
+    bool empty() const { return next == this; }
+
+    void unlink()
+    {
+        prev->next = next;
+        next->prev = prev;
+        prev = next = this;
+    }
+
+    // Used on a head, files link last.
+    void pushBack(BehaviourLink& link)
+    {
+        link.unlink();
+        link.prev  = prev;
+        link.next  = this;
+        prev->next = &link;
+        prev       = &link;
+    }
+
+    // Used on a head, moves everything in this list to the end
+    // of the one headed by other.
+    void moveTo(BehaviourLink& other)
+    {
+        if(empty())
+            return;
+        next->prev = other.prev;
+        prev->next = &other;
+        other.prev->next = next;
+        other.prev = prev;
+        prev = next = this;
+    }
+};
+
+// co_await'ed by scripts. Only notes what the script waits for,
+// the world files it accordingly once it has suspended.
+struct BehaviourAwait
+{
+    BehaviourWait wait;
+    int32_t argument;
+
+    bool await_ready() const noexcept { return false; }
+
+    template<class Promise>
+    void await_suspend(coroutine_handle<Promise> handle) const noexcept
+    {
+        handle.promise().wait     = wait;
+        handle.promise().argument = argument;
+    }
+
+    void await_resume() const noexcept {}
+};
+
+// The enemy a script steers, always its first parameter. Only used
+// while the script runs, which is during its world's enemy turn
+// while the enemy is alive. Moves and attacks are what the enemy
+// does this turn, they're applied with everybody else's.
+class Actor
+{
+
+private:
+
+    World* world_;
+    EntityId id_;
+
+    size_t slot() const;
+    EnemyAction& action() const;
+
+public:
+
+    Actor(World& world, EntityId id) : world_(&world), id_(id) {}
+
+    EntityId getId() const { return id_; }
+    FramePool& getFrames() const;
+
+    // The state of the script running the enemy.
+    BehaviourState& getState() const;
+
+    position getPosition() const;
+    position getHome() const;
+    int getHealth() const;
+
+    // Within radius cells, or null.
+    Player* findPlayer(int radius) const;
+
+    // Hits a player next to the enemy, false when there is none.
+    bool attack() const;
+
+    // One step, diagonals included, around walls in the way.
+    void stepTowards(position target) const;
+
+    // Down the world's flow field towards the closest player,
+    // false when there's no way there.
+    bool followPlayers() const;
+
+    BehaviourAwait nextTurn() const { return wait(1); }
+    BehaviourAwait wait(int turns) const { return { BehaviourWait::TURNS, max(turns, 1) }; }
+    BehaviourAwait untilPlayerWithin(int radius) const { return { BehaviourWait::PLAYER, radius }; }
+    BehaviourAwait untilHurt() const { return { BehaviourWait::HURT, 0 }; }
+};
+
+class Behaviour;
+using BehaviourScript = Behaviour (*)(Actor);
+
+// A behaviour script, written as a coroutine that steers one enemy
+// over many turns and co_awaits the next turn or a condition between
+// its moves.
+//
+// A frame can't be written to a save, so a loaded or undone world
+// starts each script over from the top with the state it had. For
+// that to carry on where the script was, whatever has to outlive a
+// co_await goes in the BehaviourState, and nothing but going back
+// round the script's loop follows a co_await. The phase is set to
+// what comes after the wait before waiting:
+//
+//   Behaviour sentry(Actor self)
+//   {
+//       BehaviourState& state = self.getState();
+//       for(;;)
+//       {
+//           switch(state.phase)
+//           {
+//               case WATCHING:
+//                   state.phase = CHASING;
+//                   co_await self.untilPlayerWithin(4);
+//                   break;
+//               ...
+//           }
+//       }
+//   }
+//
+// The script starts suspended and first runs in the enemy turn after
+// it's handed to World::runBehaviour. Frames come from the world's
+// FramePool, with the pool's address kept in front of the frame so
+// it can be given back.
+class Behaviour
+{
+
+public:
+
+    struct promise_type : BehaviourLink
+    {
+        EntityId self = 0;
+        uint64_t wakeTurn = 0;
+        int32_t argument = 0;
+        BehaviourWait wait = BehaviourWait::NONE;
+        BehaviourState state;
+        // As registered in BehaviourScripts.
+        string_view name;
+
+        static constexpr size_t HEADER = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+        template<class... Args>
+        promise_type(const Actor& actor, const Args&...) : self(actor.getId()) {}
+
+        template<class... Args>
+        static void* operator new(size_t size, const Actor& actor, const Args&...)
+        {
+            FramePool& frames = actor.getFrames();
+            char* block = static_cast<char*>(frames.allocate(size + HEADER));
+            *reinterpret_cast<FramePool**>(block) = &frames;
+            return block + HEADER;
+        }
+
+        static void operator delete(void* frame, size_t size)
+        {
+            char* block = static_cast<char*>(frame) - HEADER;
+            (*reinterpret_cast<FramePool**>(block))->release(block, size + HEADER);
+        }
+
+        Behaviour get_return_object()
+        {
+            return Behaviour(coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        suspend_always initial_suspend() noexcept { return {}; }
+
+        suspend_always final_suspend() noexcept
+        {
+            wait = BehaviourWait::DONE;
+            return {};
+        }
+
+        void return_void() {}
+        void unhandled_exception() { terminate(); }
+    };
+
+private:
+
+    coroutine_handle<promise_type> handle_;
+
+    explicit Behaviour(coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+public:
+
+    Behaviour() = default;
+
+    Behaviour(Behaviour&& other) noexcept : handle_(exchange(other.handle_, nullptr)) {}
+
+    Behaviour& operator=(Behaviour&& other) noexcept
+    {
+        if(this != &other)
+        {
+            if(handle_)
+                handle_.destroy();
+            handle_ = exchange(other.handle_, nullptr);
+        }
+        return *this;
+    }
+
+    ~Behaviour()
+    {
+        if(handle_)
+            handle_.destroy();
+    }
+
+    explicit operator bool() const { return static_cast<bool>(handle_); }
+
+    promise_type& promise() const { return handle_.promise(); }
+
+    void resume() const { handle_.resume(); }
+};
+
+// Scripts by name, so saves can say which script an enemy ran and
+// loading can start it again. Registered with a static in the file
+// that defines the script, World::runBehaviour only takes scripts
+// found here.
+class BehaviourScripts
+{
+
+private:
+
+    static vector< pair<string_view, BehaviourScript> >& table()
+    {
+        static vector< pair<string_view, BehaviourScript> > scripts;
+        return scripts;
+    }
+
+public:
+
+    static bool add(string_view name, BehaviourScript script)
+    {
+        table().emplace_back(name, script);
+        return true;
+    }
+
+    // Empty when script isn't registered.
+    static string_view nameOf(BehaviourScript script)
+    {
+        for(auto& [name, registered] : table())
+        {
+            if(registered == script)
+                return name;
+        }
+        return string_view();
+    }
+
+    // Null when no script has that name.
+    static BehaviourScript find(string_view name)
+    {
+        for(auto& [registered, script] : table())
+        {
+            if(registered == name)
+                return script;
+        }
+        return nullptr;
+    }
+};
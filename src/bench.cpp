@@ -0,0 +1,562 @@
+#include "bench.h"
+#include "parser.h"
+#include "setup.h"
+
+// Keeps the compiler from dropping a result nobody reads.
+template<class T>
+inline void benchKeep(const T& value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// Takes anything, so drawing is measured without the terminal.
+class NullBuffer : public streambuf
+{
+
+protected:
+
+    int overflow(int c) override { return c; }
+    streamsize xsputn(const char*, streamsize count) override { return count; }
+};
+
+// Scripts for the benchmark below, one resumed every turn and one
+// waiting for damage that never comes.
+Behaviour idleBehaviour(Actor self)
+{
+    for(;;)
+        co_await self.nextTurn();
+}
+
+Behaviour dormantBehaviour(Actor self)
+{
+    BehaviourState& state = self.getState();
+    if(state.phase++ == 0)
+        co_await self.untilHurt();
+}
+
+const bool benchScriptsRegistered = BehaviourScripts::add("idle", idleBehaviour)
+    && BehaviourScripts::add("dormant", dormantBehaviour);
+
+// Kept out of line so the baseline pays for a real call.
+__attribute__((noinline)) void plainCall(EnemyAction& action, position pos)
+{
+    action.target = pos;
+}
+
+void runBehaviourBenchmark()
+{
+    const int enemyCount = 100000;
+    const int turns = 50;
+
+    auto timeTurns = [&](Behaviour (*script)(Actor)) {
+        World world{limits(512, 512), 1};
+        for(int i = 0; i < enemyCount; i++)
+        {
+            EntityId id = world.spawnEnemy<BlindBatArchetype>(
+                    position(i / 512 % 512, i % 512), string());
+            world.runBehaviour(id, script);
+        }
+        world.EnemiesTurn();
+
+        auto start = chrono::steady_clock::now();
+        for(int turn = 0; turn < turns; turn++)
+            world.EnemiesTurn();
+        auto end = chrono::steady_clock::now();
+        return chrono::duration<double, nano>(end - start).count() / turns;
+    };
+
+    double resumed = timeTurns(idleBehaviour);
+    double dormant = timeTurns(dormantBehaviour);
+
+    vector<EnemyAction> actions(enemyCount);
+    void (*volatile call)(EnemyAction&, position) = plainCall;
+    auto start = chrono::steady_clock::now();
+    for(int turn = 0; turn < turns; turn++)
+    {
+        for(int i = 0; i < enemyCount; i++)
+            call(actions[i], position(turn, i));
+    }
+    auto end = chrono::steady_clock::now();
+    double plain = chrono::duration<double, nano>(end - start).count() / turns;
+
+    cout << enemyCount << " scripts resumed : " << (resumed - dormant) / 1000 << " us/turn, "
+         << (resumed - dormant) / enemyCount << " ns each" << endl;
+    cout << enemyCount << " plain calls     : " << plain / 1000 << " us/turn, "
+         << plain / enemyCount << " ns each" << endl;
+}
+
+// Enemies as they were kept before the entity store, to time the
+// store against: one list of shared_ptr per entity type, a heap
+// object per enemy, and a turn that copies lists and pointers as
+// it walks them.
+class LegacyEntity
+{
+
+public:
+
+    enum class ENTYPE { ENEMY, PLAYER };
+
+    ENTYPE entityType_;
+
+    LegacyEntity(ENTYPE type, string Name, int Health, int Attack, position Position, char Sprite)
+    : entityType_(type), health_(Health), attack_(Attack), name_(Name),
+      entityPosition_(Position), sprite_(Sprite) {}
+
+    virtual ~LegacyEntity() = default;
+
+    void setPosition(position Position, limits worldLimits)
+    {
+        entityPosition_ = Entity::clampPosition(Position, worldLimits);
+        lastPositions_.push_front(entityPosition_);
+        if(lastPositions_.size() > 3) lastPositions_.pop_back();
+    }
+
+    void receiveDamage(int damage) { health_ -= damage; }
+
+    string getName() { return name_; }
+    position getPosition() { return entityPosition_; }
+    char getSprite() { return sprite_; }
+    int getAttack() { return attack_; }
+
+private:
+
+    int health_;
+    int attack_;
+    string name_;
+    position entityPosition_;
+    deque<position> lastPositions_;
+    char sprite_;
+};
+
+class LegacyBat : public LegacyEntity
+{
+
+private:
+
+    position squareMiddle_;
+    vector<position> possiblePositions_;
+
+public:
+
+    LegacyBat(string Name, position Position)
+    : LegacyEntity(ENTYPE::ENEMY, Name, 50, 10, Position, 'B'), squareMiddle_(Position) {}
+
+    vector<position> getBatAttackRadiusPositions()
+    {
+        auto [row, column] = getPosition();
+        possiblePositions_.clear();
+        for(int dr = -1; dr <= 1; dr++)
+            for(int dc = -1; dc <= 1; dc++)
+                if(dr || dc)
+                    possiblePositions_.push_back(position(row + dr, column + dc));
+        return possiblePositions_;
+    }
+
+    position getSquareMiddle() { return squareMiddle_; }
+};
+
+class LegacyWorld
+{
+
+private:
+
+    Scene worldMap_;
+    Scene baseScene_;
+    limits worldLimits_;
+    default_random_engine e_{1};
+    uniform_int_distribution<int> d_{-1, 1};
+    unordered_map<LegacyEntity::ENTYPE, list<shared_ptr<LegacyEntity>>> entities_;
+
+    void setSprite(Scene& scene, char sprite, position pos)
+    {
+        if(pos.first >= 0 && pos.first < worldLimits_.first && pos.second >= 0 && pos.second < worldLimits_.second)
+            scene[pos.first][pos.second] = sprite;
+    }
+
+public:
+
+    explicit LegacyWorld(limits worldLimits)
+    : baseScene_(worldLimits.first, string(worldLimits.second, '.')), worldLimits_(worldLimits)
+    {
+        worldMap_ = baseScene_;
+    }
+
+    void addEntity(shared_ptr<LegacyEntity> entity)
+    {
+        entities_[entity->entityType_].push_back(move(entity));
+    }
+
+    shared_ptr<LegacyEntity> getPlayer(size_t playerIndex)
+    {
+        auto player = entities_.find(LegacyEntity::ENTYPE::PLAYER)->second.begin();
+        advance(player, playerIndex);
+        return *player;
+    }
+
+    list<shared_ptr<LegacyEntity>>& getEnemies()
+    {
+        return entities_.find(LegacyEntity::ENTYPE::ENEMY)->second;
+    }
+
+    void resetWorldMap() { worldMap_ = baseScene_; }
+
+    void EnemiesTurn()
+    {
+        auto enemies = getEnemies();
+        for(auto enemyEntity : enemies)
+        {
+            auto player = getPlayer(0);
+            auto blindbat = static_pointer_cast<LegacyBat>(enemyEntity);
+
+            position playerPosition = player->getPosition();
+            position batPosition    = blindbat->getPosition();
+            position squareMiddle   = blindbat->getSquareMiddle();
+
+            if(abs(playerPosition.first - batPosition.first) < 2
+                    && abs(playerPosition.second - batPosition.second) < 2)
+            {
+                player->receiveDamage(blindbat->getAttack());
+                for(auto pos : blindbat->getBatAttackRadiusPositions())
+                    setSprite(worldMap_, '^', pos);
+            }
+            else
+            {
+                blindbat->setPosition(position(squareMiddle.first + d_(e_),
+                            squareMiddle.second + d_(e_)), worldLimits_);
+            }
+        }
+    }
+
+    void drawMap(ostream& out)
+    {
+        for(auto entities : entities_)
+            for(auto entityPointer : entities.second)
+                if(entityPointer)
+                    setSprite(worldMap_, entityPointer->getSprite(), entityPointer->getPosition());
+
+        for(auto l : worldMap_)
+            out << l << endl;
+    }
+};
+
+void runTurnBenchmark(ThreadPool& pool)
+{
+    cout << "threads : " << pool.getThreadCount() << endl;
+
+    // Bats moving and drawing, in both layouts.
+    for(int enemyCount : {10000, 100000})
+    {
+        World world{};
+        world.setShouldDrawEntities(true);
+        LegacyWorld legacy{world.getWorldLimits()};
+
+        Player player1("John", 1 << 30, 20, 30,  position(4, 23), 'J');
+        world.addEntity(player1);
+        legacy.addEntity(make_shared<LegacyEntity>(LegacyEntity::ENTYPE::PLAYER, "John", 1 << 30, 20,
+                    position(4, 23), 'J'));
+
+        mt19937 gen(1);
+        limits worldLimits = world.getWorldLimits();
+        for(int i = 0; i < enemyCount; i++)
+        {
+            position pos(gen() % worldLimits.first, gen() % worldLimits.second);
+            string name = "Blind Bat " + to_string(i);
+            world.spawnEnemy<BlindBatArchetype>(pos, name);
+            legacy.addEntity(make_shared<LegacyBat>(name, pos));
+        }
+
+        ofstream nullSink("/dev/null");
+        auto timeTurn = [&](auto turn) {
+            const int turns = 20;
+            turn();
+            auto start = chrono::steady_clock::now();
+            for(int i = 0; i < turns; i++)
+                turn();
+            auto end = chrono::steady_clock::now();
+            return chrono::duration<double, micro>(end - start).count() / turns;
+        };
+
+        double before = timeTurn([&] {
+            legacy.resetWorldMap();
+            legacy.EnemiesTurn();
+            legacy.drawMap(nullSink);
+        });
+        double after = timeTurn([&] {
+            world.resetWorldMap();
+            world.EnemiesTurn();
+            world.drawMap(nullSink);
+        });
+        cout << enemyCount << " bats, shared_ptr lists : " << before << " us/turn, entity store : "
+             << after << " us/turn (" << before / after << "x)" << endl;
+    }
+
+    auto timeTurns = [&](World& world, const char* kind, int enemyCount) {
+        auto player = world.getPlayer(0);
+        ofstream nullSink("/dev/null");
+
+        const int turns = 50;
+        auto start = chrono::steady_clock::now();
+        for(int turn = 0; turn < turns; turn++)
+        {
+            world.resetWorldMap();
+            player->checkCollisions(world);
+            world.EnemiesTurn();
+            world.drawPlayerActions();
+            world.drawMap(nullSink);
+            player->attack(SWING, turn % 2 ? Facing::LEFT : Facing::RIGHT, world);
+
+            // Keeps the hounds' field moving.
+            position pos = player->getPosition();
+            player->setPosition(position(pos.first, pos.second + (turn % 4 < 2 ? 1 : -1)),
+                    world.getWorldLimits());
+        }
+        auto end = chrono::steady_clock::now();
+
+        cout << enemyCount << " " << kind << " : "
+             << chrono::duration<double, micro>(end - start).count() / turns
+             << " us/turn" << endl;
+    };
+
+    for(int enemyCount : {10000, 100000})
+    {
+        World world{};
+        world.setShouldDrawEntities(true);
+        world.setThreadPool(&pool);
+
+        Player player1("John", 200, 20, 30,  position(4, 23), 'J');
+        world.addEntity(player1);
+
+        mt19937 gen(1);
+        limits worldLimits = world.getWorldLimits();
+        for(int i = 0; i < enemyCount; i++)
+        {
+            world.spawnEnemy<BlindBatArchetype>(position(gen() % worldLimits.first,
+                        gen() % worldLimits.second), "Blind Bat " + to_string(i));
+        }
+
+        timeTurns(world, "bats", enemyCount);
+    }
+
+    for(int enemyCount : {1000, 10000, 100000})
+    {
+        World world{limits(512, 512), 1};
+        world.setShouldDrawEntities(true);
+        world.setThreadPool(&pool);
+
+        Player player1("John", 200000, 20, 30,  position(256, 256), 'J');
+        world.addEntity(player1);
+        scatterHounds(world, enemyCount, 1);
+
+        timeTurns(world, "hounds", enemyCount);
+    }
+}
+
+void runBenchSuite(BenchSuite& suite, ThreadPool& pool)
+{
+    const long entityCounts[] = { 10, 100, 1000, 10000, 100000, 1000000 };
+    const limits worldSizes[] = { World::defaultWorldLimits(), limits(256, 256), limits(2048, 2048) };
+    const int sturdy = 1 << 30;
+
+    // Strings.
+    Helper helper;
+    Parser parser{};
+    const string_view lines[] = { "attack left", "  move   up  ",
+        "a b c d e f g h i j k l m n o p q r s t u v w x y z 0 1 2 3 4 5" };
+    for(string_view line : lines)
+    {
+        string_view tokens[32];
+        suite.measure("split_string", static_cast<long>(line.size()), limits(0, 0), [&](long n) {
+            for(long i = 0; i < n; i++)
+            {
+                benchKeep(line);
+                benchKeep(helper.splitString(line, ' ', tokens, 32));
+            }
+        });
+        suite.measure("trim", static_cast<long>(line.size()), limits(0, 0), [&](long n) {
+            for(long i = 0; i < n; i++)
+            {
+                benchKeep(line);
+                benchKeep(parser.trim(line));
+            }
+        });
+    }
+
+    // Command mixes on the starting scene, bats can't die.
+    const vector<string_view> mixes[] = {
+        { "up", "left", "down", "right", "back" },
+        { "attack left", "attack right", "cone up", "burst", "a d" },
+        { "up", "attack left", "  right ", "cone down", "dance", "", "b", "burst", "l", "r" },
+    };
+    const char* mixNames[] = { "parse_moves", "parse_attacks", "parse_mixed" };
+    for(size_t mix = 0; mix < size(mixes); mix++)
+    {
+        World world{1};
+        spawnDefaultEntities(world);
+        auto& commands = mixes[mix];
+        suite.measure(mixNames[mix], static_cast<long>(commands.size()), world.getWorldLimits(), [&](long n) {
+            for(long i = 0; i < n; i++)
+            {
+                benchKeep(parser.parseCommand(commands[i % commands.size()], world));
+                world.getPlayer(0)->setHealth(sturdy);
+            }
+        });
+    }
+
+    // Routines that follow the number of enemies and the world size.
+    NullBuffer nullBuffer;
+    ostream nullSink(&nullBuffer);
+    for(limits worldLimits : worldSizes)
+    {
+        for(long count : entityCounts)
+        {
+            World world{worldLimits, 1};
+            world.setShouldDrawEntities(true);
+            world.setThreadPool(&pool);
+
+            position middle(worldLimits.first / 2, worldLimits.second / 2);
+            Player player1("John", sturdy, 20, 30, middle, 'J');
+            world.addEntity(player1);
+            Player* player = world.getPlayer(0);
+
+            mt19937 gen(1);
+            for(long i = 0; i < count; i++)
+            {
+                world.spawnEnemy(ENEMY_TYPE::BLIND_BAT, string(), sturdy, BlindBatArchetype::attack,
+                        BlindBatArchetype::defense, position(gen() % worldLimits.first,
+                            gen() % worldLimits.second), BlindBatArchetype::sprite);
+            }
+
+            suite.measure("draw_map", count, worldLimits, [&](long n) {
+                for(long i = 0; i < n; i++)
+                    world.drawMap(nullSink);
+            });
+
+            suite.measure("enemies_turn_bats", count, worldLimits, [&](long n) {
+                for(long i = 0; i < n; i++)
+                {
+                    world.resetWorldMap();
+                    world.EnemiesTurn();
+                }
+                player->setHealth(sturdy);
+            });
+
+            suite.measure("check_collisions", count, worldLimits, [&](long n) {
+                for(long i = 0; i < n; i++)
+                {
+                    player->checkCollisions(world);
+                    player->setPosition(middle, worldLimits);
+                }
+            });
+
+            const pair<const char*, const AttackPattern*> patterns[] = {
+                { "attack_swing", &SWING }, { "attack_cone", &CONE }, { "attack_burst", &BURST },
+            };
+            for(auto& [name, pattern] : patterns)
+            {
+                suite.measure(name, count, worldLimits, [&](long n) {
+                    for(long i = 0; i < n; i++)
+                        player->attack(*pattern, static_cast<Facing>(i & 3), world);
+                });
+            }
+
+            // A kill is how an enemy leaves the world.
+            suite.measure("spawn_remove_enemy", count, worldLimits, [&](long n) {
+                for(long i = 0; i < n; i++)
+                {
+                    EntityId id = world.spawnEnemy<BlindBatArchetype>(middle, string());
+                    world.damageEnemy(id, BlindBatArchetype::health, 0);
+                }
+            });
+
+            suite.measure("add_remove_player", count, worldLimits, [&](long n) {
+                Player visitor("Visitor", 100, 10, 10, middle, 'V');
+                for(long i = 0; i < n; i++)
+                {
+                    world.addEntity(visitor);
+                    world.removePlayer(world.getPlayers().size() - 1);
+                }
+            });
+
+            // Against enemies_turn_bats, what keeping every turn for
+            // undo adds. Bats all move, so their position pages are new.
+            world.setHistoryDepth(256);
+            suite.measure("enemies_turn_history", count, worldLimits, [&](long n) {
+                for(long i = 0; i < n; i++)
+                {
+                    world.resetWorldMap();
+                    world.EnemiesTurn();
+                }
+                player->setHealth(sturdy);
+            });
+
+            // A turn played and taken back, the history is as long
+            // after as before. Against enemies_turn_history, what's
+            // left is keeping one more turn and the undo.
+            suite.measure("undo_turn", count, worldLimits, [&](long n) {
+                for(long i = 0; i < n; i++)
+                {
+                    world.resetWorldMap();
+                    world.EnemiesTurn();
+                    world.resetWorldMap();
+                    if(!world.undo(1))
+                        return suite.fail("undo_turn", "no turn to go back to");
+                }
+            });
+            player = world.getPlayer(0);
+        }
+
+        // A fifth of the world is wall, the player steps back and
+        // forth so every sight update is a full recompute.
+        if(suite.wants("field_of_view") || suite.wants("draw_map_fog"))
+        {
+            World world{worldLimits, 1};
+            world.setShouldDrawEntities(true);
+            world.setFog(true);
+
+            mt19937 gen(1);
+            long cells = static_cast<long>(worldLimits.first) * worldLimits.second;
+            for(long i = 0; i < cells / 5; i++)
+                world.addSpriteCollider('#', position(gen() % worldLimits.first, gen() % worldLimits.second));
+
+            position middle(worldLimits.first / 2, worldLimits.second / 2);
+            Player player1("John", sturdy, 20, 30, middle, 'J');
+            world.addEntity(player1);
+            Player* player = world.getPlayer(0);
+            position step(middle.first, middle.second + 1);
+
+            suite.measure("field_of_view", 1, worldLimits, [&](long n) {
+                for(long i = 0; i < n; i++)
+                {
+                    player->setPosition(i & 1 ? step : middle, worldLimits);
+                    benchKeep(world.getSight(0));
+                }
+            });
+            suite.measure("draw_map_fog", 1, worldLimits, [&](long n) {
+                for(long i = 0; i < n; i++)
+                    world.drawMap(nullSink);
+            });
+        }
+
+        // Hounds also pay for the flow field, which follows the world.
+        for(long count : entityCounts)
+        {
+            if(!suite.wants("enemies_turn_hounds"))
+                break;
+
+            World world{worldLimits, 1};
+            world.setThreadPool(&pool);
+            Player player1("John", sturdy, 20, 30, position(worldLimits.first / 2, worldLimits.second / 2), 'J');
+            world.addEntity(player1);
+            scatterHounds(world, static_cast<int>(count), 1);
+
+            suite.measure("enemies_turn_hounds", count, worldLimits, [&](long n) {
+                for(long i = 0; i < n; i++)
+                {
+                    world.resetWorldMap();
+                    world.EnemiesTurn();
+                }
+                world.getPlayer(0)->setHealth(sturdy);
+            });
+        }
+    }
+}
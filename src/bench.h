@@ -0,0 +1,200 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "thread_pool.h"
+
+struct BenchSuiteOptions
+{
+    // CSV results, "-" for stdout. Empty when the suite isn't run.
+    string outputPath;
+    // Earlier results to compare with, a case whose median got slower
+    // by more than tolerance percent fails the run.
+    string baselinePath;
+    double tolerance = 10;
+    // Only cases whose name contains this.
+    string filter;
+};
+
+// Microbenchmarks over the core routines, one CSV row per case:
+//   name,size,world,iterations,median_ns,min_ns,max_ns
+// Times are per call. A case's body runs the routine a given number
+// of times, iterations are grown until one sample takes SAMPLE_TIME,
+// then SAMPLES samples are taken. Rows are keyed by name, size and
+// world when compared with a baseline.
+class BenchSuite
+{
+
+private:
+
+    static constexpr double SAMPLE_TIME = 20e6;
+    static constexpr int SAMPLES = 5;
+
+    struct Result
+    {
+        string name;
+        long size;
+        string world;
+        long iterations;
+        double median, minimum, maximum;
+
+        string key() const { return name + ',' + to_string(size) + ',' + world; }
+    };
+
+    const BenchSuiteOptions& options_;
+    vector<Result> results_;
+    size_t failures_ = 0;
+
+    static string worldName(limits worldLimits)
+    {
+        return to_string(worldLimits.first) + 'x' + to_string(worldLimits.second);
+    }
+
+public:
+
+    explicit BenchSuite(const BenchSuiteOptions& options) : options_(options) {}
+
+    bool wants(const string& name) const
+    {
+        return options_.filter.empty() || name.find(options_.filter) != string::npos;
+    }
+
+    // A body that couldn't do what it times says so, the case gets
+    // no row and the run fails.
+    void fail(const string& name, const string& why)
+    {
+        cerr << name << " failed : " << why << endl;
+        failures_++;
+    }
+
+    bool hasFailures() const { return failures_ > 0; }
+
+    template<class Body>
+    void measure(const string& name, long size, limits worldLimits, Body body)
+    {
+        if(!wants(name))
+            return;
+
+        size_t failures = failures_;
+
+        auto time = [&](long iterations) {
+            auto start = chrono::steady_clock::now();
+            body(iterations);
+            auto end = chrono::steady_clock::now();
+            return chrono::duration<double, nano>(end - start).count();
+        };
+
+        long iterations = 1;
+        double elapsed = time(iterations);
+        while(elapsed < SAMPLE_TIME / 4 && failures_ == failures)
+        {
+            iterations *= elapsed > 0 ? clamp(static_cast<long>(SAMPLE_TIME / 2 / elapsed), 2L, 100L) : 100;
+            elapsed = time(iterations);
+        }
+        iterations = max(1L, static_cast<long>(iterations * SAMPLE_TIME / elapsed));
+
+        array<double, SAMPLES> samples;
+        for(auto& sample : samples)
+            sample = time(iterations) / iterations;
+        sort(samples.begin(), samples.end());
+        if(failures_ != failures)
+            return;
+
+        Result result{ name, size, worldLimits.first > 0 ? worldName(worldLimits) : "-",
+            iterations, samples[SAMPLES / 2], samples.front(), samples.back() };
+        cerr << left << setw(24) << name << right << setw(9) << size << setw(11) << result.world
+             << setw(14) << fixed << setprecision(1) << result.median << " ns" << endl;
+        results_.push_back(move(result));
+    }
+
+    bool write() const
+    {
+        ofstream file;
+        if(options_.outputPath != "-")
+        {
+            file.open(options_.outputPath, ios::trunc);
+            if(!file)
+            {
+                cerr << "Could not write " << options_.outputPath << endl;
+                return false;
+            }
+        }
+        ostream& out = options_.outputPath == "-" ? cout : file;
+
+        out << "name,size,world,iterations,median_ns,min_ns,max_ns\n" << fixed << setprecision(2);
+        for(auto& result : results_)
+        {
+            out << result.key() << ',' << result.iterations << ',' << result.median << ','
+                << result.minimum << ',' << result.maximum << '\n';
+        }
+        out.flush();
+        return static_cast<bool>(out);
+    }
+
+    // Lists the cases that got slower than the baseline allows,
+    // false when there's any or the baseline can't be read.
+    bool compare() const
+    {
+        if(options_.baselinePath.empty())
+            return true;
+
+        ifstream file(options_.baselinePath);
+        if(!file)
+        {
+            cerr << "Could not read " << options_.baselinePath << endl;
+            return false;
+        }
+
+        unordered_map<string, double> baseline;
+        string line;
+        getline(file, line);
+        while(getline(file, line))
+        {
+            // key is the first three fields, the median the fifth.
+            size_t fields[4];
+            size_t at = 0;
+            for(size_t i = 0; i < 4 && at != string::npos; i++)
+            {
+                at = line.find(',', i ? at + 1 : 0);
+                fields[i] = at;
+            }
+            if(at != string::npos)
+                baseline[line.substr(0, fields[2])] = atof(line.c_str() + fields[3] + 1);
+        }
+
+        size_t regressions = 0, compared = 0;
+        for(auto& result : results_)
+        {
+            auto it = baseline.find(result.key());
+            if(it == baseline.end() || it->second <= 0)
+                continue;
+
+            compared++;
+            double change = (result.median / it->second - 1) * 100;
+            if(change > options_.tolerance)
+            {
+                regressions++;
+                cerr << "regression: " << result.key() << " " << it->second << " -> "
+                     << result.median << " ns (" << showpos << change << noshowpos << "%)" << endl;
+            }
+        }
+        cerr << compared << " cases compared, " << regressions << " slower than "
+             << options_.tolerance << "%" << endl;
+        return regressions == 0;
+    }
+};
+
+// Resuming a script against a plain call per enemy. Both worlds run
+// the same turn, in one every bat's script is resumed and suspends
+// again, in the other they all wait for damage that never comes, so
+// the difference is the cost of the resumes.
+void runBehaviourBenchmark();
+
+// Times the per turn systems with a lot of bats scattered
+// around the map, then with hounds chasing the player on a
+// bigger one. Bats are also run in the old shared_ptr list
+// layout to compare with. Nothing is drawn to the terminal.
+void runTurnBenchmark(ThreadPool& pool);
+
+void runBenchSuite(BenchSuite& suite, ThreadPool& pool);
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "common.h"
+
+// Terrain stored as fixed size square chunks. Chunks nobody wrote to
+// all point at one shared default chunk, so a huge world only costs
+// memory where it differs from plain ground.
+class ChunkedMap
+{
+
+public:
+
+    static constexpr int CHUNK_SHIFT = 6;
+    static constexpr int CHUNK_SIZE  = 1 << CHUNK_SHIFT;
+    static constexpr int CHUNK_MASK  = CHUNK_SIZE - 1;
+    static constexpr size_t CHUNK_CELLS = CHUNK_SIZE * CHUNK_SIZE;
+
+private:
+
+    limits limits_ {0, 0};
+    int chunkColumns_ = 0;
+    char ground_ = '.';
+
+    vector<char> defaultChunk_;
+    vector<const char*> chunks_;
+    vector< unique_ptr<char[]> > owned_;
+
+    size_t chunkIndex(position pos) const
+    {
+        return static_cast<size_t>(pos.first >> CHUNK_SHIFT) * chunkColumns_
+            + (pos.second >> CHUNK_SHIFT);
+    }
+
+    static size_t cellInChunk(position pos)
+    {
+        return (pos.first & CHUNK_MASK) * CHUNK_SIZE + (pos.second & CHUNK_MASK);
+    }
+
+public:
+
+    void reset(limits worldLimits, char ground)
+    {
+        limits_ = worldLimits;
+        ground_ = ground;
+        chunkColumns_ = (worldLimits.second + CHUNK_MASK) >> CHUNK_SHIFT;
+        size_t chunkRows = (worldLimits.first + CHUNK_MASK) >> CHUNK_SHIFT;
+
+        defaultChunk_.assign(CHUNK_CELLS, ground);
+        chunks_.assign(chunkRows * chunkColumns_, defaultChunk_.data());
+        owned_.clear();
+        owned_.resize(chunks_.size());
+    }
+
+    bool inside(position pos) const
+    {
+        return pos.first >= 0 && pos.first < limits_.first
+            && pos.second >= 0 && pos.second < limits_.second;
+    }
+
+    char at(position pos) const
+    {
+        return chunks_[chunkIndex(pos)][cellInChunk(pos)];
+    }
+
+    // Copies the chunk on first write if it is still shared.
+    void set(position pos, char sprite)
+    {
+        if(!inside(pos))
+            return;
+
+        size_t index = chunkIndex(pos);
+        if(!owned_[index])
+        {
+            owned_[index] = make_unique<char[]>(CHUNK_CELLS);
+            memcpy(owned_[index].get(), chunks_[index], CHUNK_CELLS);
+            chunks_[index] = owned_[index].get();
+        }
+        owned_[index][cellInChunk(pos)] = sprite;
+    }
+
+    // Copies count cells of a row, starting at column, into out.
+    void copyRow(int row, int column, int count, char* out) const
+    {
+        while(count > 0)
+        {
+            position pos(row, column);
+            int run = min(count, CHUNK_SIZE - (column & CHUNK_MASK));
+            memcpy(out, chunks_[chunkIndex(pos)] + cellInChunk(pos), run);
+            out    += run;
+            column += run;
+            count  -= run;
+        }
+    }
+
+    // Points chunks at terrain that lives somewhere else, like a
+    // mapped level file. A zero offset means plain ground.
+    void attach(limits worldLimits, char ground, const char* base, const uint64_t* chunkOffsets)
+    {
+        reset(worldLimits, ground);
+        for(size_t i = 0; i < chunks_.size(); i++)
+        {
+            if(chunkOffsets[i])
+                chunks_[i] = base + chunkOffsets[i];
+        }
+    }
+
+    char getGround() const { return ground_; }
+    size_t getChunkCount() const { return chunks_.size(); }
+    int getChunkColumns() const { return chunkColumns_; }
+
+    // Still the all ground chunk every untouched chunk shares.
+    bool isPlain(size_t index) const { return chunks_[index] == defaultChunk_.data(); }
+
+    const char* getChunk(size_t index) const { return chunks_[index]; }
+    bool isOwned(size_t index) const { return owned_[index] != nullptr; }
+
+    // Overwrites a whole chunk, taking a private copy of it.
+    void setChunk(size_t index, const char* data)
+    {
+        if(!owned_[index])
+        {
+            owned_[index] = make_unique<char[]>(CHUNK_CELLS);
+            chunks_[index] = owned_[index].get();
+        }
+        memcpy(owned_[index].get(), data, CHUNK_CELLS);
+    }
+
+    size_t getOwnedChunkCount() const
+    {
+        size_t count = 0;
+        for(auto& chunk : owned_)
+            count += chunk != nullptr;
+        return count;
+    }
+};
@@ -0,0 +1,220 @@
+#pragma once
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "chunked_map.h"
+
+// One bit per cell, set where something blocks movement. Laid out
+// in the same 64x64 chunks as the terrain with one 64 bit word per
+// chunk row, and chunks without walls share a single empty one, so
+// a huge open world costs one pointer per chunk. Anything outside
+// the world counts as blocked.
+class CollisionMask
+{
+
+public:
+
+    using Rows = array<uint64_t, ChunkedMap::CHUNK_SIZE>;
+
+private:
+
+    limits limits_ {0, 0};
+    int chunkColumns_ = 0;
+
+    // chunks_ points into this, so masks stay where they are.
+    Rows openChunk_ {};
+    vector<const Rows*> chunks_;
+    vector< unique_ptr<Rows> > owned_;
+
+    static constexpr int SHIFT = ChunkedMap::CHUNK_SHIFT;
+    static constexpr int MASK  = ChunkedMap::CHUNK_MASK;
+
+    size_t chunkIndex(int row, int column) const
+    {
+        return static_cast<size_t>(row >> SHIFT) * chunkColumns_ + (column >> SHIFT);
+    }
+
+    Rows& own(size_t index)
+    {
+        if(!owned_[index])
+        {
+            owned_[index] = make_unique<Rows>(*chunks_[index]);
+            chunks_[index] = owned_[index].get();
+        }
+        return *owned_[index];
+    }
+
+    // Bits first to last of a word, both inclusive.
+    static uint64_t bitRange(int first, int last)
+    {
+        uint64_t upTo = last == 63 ? ~0ull : (1ull << (last + 1)) - 1;
+        return upTo & ~((1ull << first) - 1);
+    }
+
+    // Whether any of rows first to last, masked by bits, is blocked.
+    static bool anyBlocked(const Rows& rows, int first, int last, uint64_t bits)
+    {
+        int row = first;
+#if defined(__SSE2__)
+        __m128i mask = _mm_set1_epi64x(static_cast<long long>(bits));
+        __m128i blocked = _mm_setzero_si128();
+        for(; row + 3 <= last; row += 4)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&rows[row]));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&rows[row + 2]));
+            blocked = _mm_or_si128(blocked, _mm_and_si128(_mm_or_si128(a, b), mask));
+        }
+        if(_mm_movemask_epi8(_mm_cmpeq_epi8(blocked, _mm_setzero_si128())) != 0xffff)
+            return true;
+#endif
+        uint64_t rest = 0;
+        for(; row <= last; row++)
+            rest |= rows[row];
+        return (rest & bits) != 0;
+    }
+
+public:
+
+    CollisionMask() = default;
+    CollisionMask(const CollisionMask&) = delete;
+    CollisionMask& operator=(const CollisionMask&) = delete;
+
+    void reset(limits worldLimits)
+    {
+        limits_ = worldLimits;
+        chunkColumns_ = (worldLimits.second + MASK) >> SHIFT;
+        size_t chunkRows = (worldLimits.first + MASK) >> SHIFT;
+
+        chunks_.assign(chunkRows * chunkColumns_, &openChunk_);
+        owned_.clear();
+        owned_.resize(chunks_.size());
+    }
+
+    // Everything that isn't plain ground is blocked. Chunks still
+    // shared with the default terrain are skipped, the rest are
+    // compared 16 cells at a time.
+    void build(const ChunkedMap& terrain, limits worldLimits)
+    {
+        reset(worldLimits);
+        char ground = terrain.getGround();
+
+        for(size_t index = 0; index < chunks_.size(); index++)
+        {
+            if(terrain.isPlain(index))
+                continue;
+
+            const char* cells = terrain.getChunk(index);
+            Rows rows {};
+            uint64_t any = 0;
+            for(int row = 0; row < ChunkedMap::CHUNK_SIZE; row++)
+            {
+                const char* line = cells + row * ChunkedMap::CHUNK_SIZE;
+                uint64_t open = 0;
+#if defined(__SSE2__)
+                __m128i plain = _mm_set1_epi8(ground);
+                for(int column = 0; column < ChunkedMap::CHUNK_SIZE; column += 16)
+                {
+                    __m128i chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(line + column));
+                    uint64_t same = static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chars, plain)));
+                    open |= same << column;
+                }
+#else
+                for(int column = 0; column < ChunkedMap::CHUNK_SIZE; column++)
+                    open |= static_cast<uint64_t>(line[column] == ground) << column;
+#endif
+                rows[row] = ~open;
+                any |= ~open;
+            }
+
+            if(any)
+                own(index) = rows;
+        }
+    }
+
+    bool inside(position pos) const
+    {
+        return pos.first >= 0 && pos.first < limits_.first
+            && pos.second >= 0 && pos.second < limits_.second;
+    }
+
+    void setBlocked(position pos, bool blocked)
+    {
+        if(!inside(pos))
+            return;
+
+        uint64_t& row = own(chunkIndex(pos.first, pos.second))[pos.first & MASK];
+        uint64_t bit = 1ull << (pos.second & MASK);
+        row = blocked ? row | bit : row & ~bit;
+    }
+
+    bool isBlocked(position pos) const
+    {
+        if(!inside(pos))
+            return true;
+        return (*chunks_[chunkIndex(pos.first, pos.second)])[pos.first & MASK]
+            >> (pos.second & MASK) & 1;
+    }
+
+    // length cells of row starting at column, going right.
+    bool isRowRunOpen(int row, int column, int length) const
+    {
+        if(length <= 0)
+            return true;
+        if(row < 0 || row >= limits_.first || column < 0 || column + length > limits_.second)
+            return false;
+
+        int last = column + length - 1;
+        while(column <= last)
+        {
+            int chunkLast = min(last, column | MASK);
+            uint64_t word = (*chunks_[chunkIndex(row, column)])[row & MASK];
+            if(word & bitRange(column & MASK, chunkLast & MASK))
+                return false;
+            column = chunkLast + 1;
+        }
+        return true;
+    }
+
+    // length cells of column starting at row, going down.
+    bool isColumnRunOpen(int row, int column, int length) const
+    {
+        return isRectOpen(position(row, column), limits(length, 1));
+    }
+
+    bool isRectOpen(position origin, limits size) const
+    {
+        if(size.first <= 0 || size.second <= 0)
+            return true;
+
+        int rowLast    = origin.first + size.first - 1;
+        int columnLast = origin.second + size.second - 1;
+        if(origin.first < 0 || origin.second < 0
+                || rowLast >= limits_.first || columnLast >= limits_.second)
+            return false;
+
+        for(int row = origin.first; row <= rowLast; row = (row | MASK) + 1)
+        {
+            int chunkRowLast = min(rowLast, row | MASK);
+            for(int column = origin.second; column <= columnLast; column = (column | MASK) + 1)
+            {
+                const Rows* rows = chunks_[chunkIndex(row, column)];
+                if(rows == &openChunk_)
+                    continue;
+
+                uint64_t bits = bitRange(column & MASK, min(columnLast, column | MASK) & MASK);
+                if(anyBlocked(*rows, row & MASK, chunkRowLast & MASK, bits))
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    size_t getOwnedChunkCount() const
+    {
+        size_t count = 0;
+        for(auto& chunk : owned_)
+            count += chunk != nullptr;
+        return count;
+    }
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <unordered_map>
+#include <list>
+#include <assert.h>
+#include <sstream>
+#include <iomanip>
+#include <deque>
+#include <memory>
+#include <random>
+#include <chrono>
+#include <fstream>
+#include <cstring>
+#include <string_view>
+#include <algorithm>
+#include <numeric>
+#include <array>
+#include <atomic>
+#include <new>
+#include <cstdlib>
+#include <cmath>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <tuple>
+#include <utility>
+#include <coroutine>
+#include <charconv>
+
+using namespace std;
+using position = pair<int, int>;
+using limits = position;
+using EntityId = uint64_t;
+
+class World;
+class Player;
+class SnapshotWriter;
+class SnapshotReader;
+class Helper;
+
+#define debug(x) std::cout << #x << " = " << x << "\n";
+#define vdebug(a) std::cout << #a << " = "; for(auto x: a) std::cout << x << " "; std::cout << "\n";
+
+// Opt in heap allocation counting (--count-allocs), lets a run check
+// that the turn loop stops allocating once it has warmed up.
+extern bool allocationTracking;
+extern atomic<size_t> allocationCount;
+
+// Opt in live heap bytes per thread, the room manager charges the
+// difference across a room's jobs to that room.
+extern bool heapTracking;
+extern thread_local int64_t threadHeapBytes;
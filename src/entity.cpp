@@ -0,0 +1,66 @@
+#include "world.h"
+
+// Targets are collected as ids before any damage is dealt. A kill
+// swaps another enemy into the dead one's slot, ids don't move.
+void Player::attack(const AttackPattern& pattern, Facing facing, World & world)
+{
+    clearAttack();
+
+    const vector<position>& cells = world.resolveAttackCells(pattern, facing, getPosition());
+    char sprite = pattern.sprites[static_cast<size_t>(facing)];
+    for(auto& pos : cells)
+        pushAttack(sprite, pos);
+
+    const vector<EntityId>& targets = world.collectEnemyIdsIn(cells);
+    world.logEvent(EventKind::ATTACK, playerEventId(getSlot()), 0, getPosition(), position(),
+            static_cast<int>(cells.size()), static_cast<int>(targets.size()));
+    for(auto id : targets)
+    {
+        setLastAttackedEnemy(id);
+        world.damageEnemy(id, getAttack(), playerEventId(getSlot()));
+    }
+}
+
+void Entity::receiveDamage(int damage)
+{
+    int newHealth = evaluateDamage(damage);      
+    if(newHealth > 0)
+    {
+        this->setHealth(newHealth);
+    } 
+    else
+    {
+        // Players can't be released from the world yet.
+        this->setHealth(0);
+    }
+}
+
+void Player::checkCollisions(World& world)
+{
+    PROFILE_SCOPE(CHECK_COLLISIONS);
+    PROFILE_COUNT(ENTITIES, 1);
+
+    if(world.hasEnemyAt(this->getPosition()))
+        moveBackOnePosition(world);
+
+    if(!world.isPassable(this->getPosition()))
+        moveBackOnePosition(world);
+}
+
+void Entity::notifyMove(position from, position to)
+{
+    if(world_)
+    {
+        world_->logEvent(EventKind::MOVE, playerEventId(slot_), 0, from, to);
+        world_->playerIndex_.move(slot_, from, to);
+    }
+}
+
+void Player::moveBackOnePosition(World & world)
+{
+    auto& last_ = getLastPositions();
+    if(last_.size() > 1)
+    {
+        setPosition(last_[1], world.getWorldLimits());
+    }
+}
@@ -0,0 +1,373 @@
+#pragma once
+
+#include "profiler.h"
+
+class Helper 
+{
+
+public:
+    // Splits without copying, empty tokens are skipped. Returns how many
+    // tokens were written, anything past maxTokens is dropped.
+    size_t splitString(string_view str, char delimiter,
+            string_view* tokens, size_t maxTokens) {
+        size_t count = 0;
+        size_t begin = 0;
+        while(begin < str.size() && count < maxTokens) {
+            size_t end = str.find(delimiter, begin);
+            if(end == string_view::npos)
+                end = str.size();
+            if(end > begin)
+                tokens[count++] = str.substr(begin, end - begin);
+            begin = end + 1;
+        }
+        return count;
+    }
+
+};
+
+// The last few positions an entity stood on, newest first.
+// Kept in a fixed ring so moving never allocates.
+class MoveHistory
+{
+
+private:
+
+    static constexpr size_t CAPACITY = 3;
+
+    position positions_[CAPACITY];
+    size_t newest_ = 0;
+    size_t size_ = 0;
+
+public:
+
+    void push(position pos)
+    {
+        newest_ = (newest_ + CAPACITY - 1) % CAPACITY;
+        positions_[newest_] = pos;
+        if(size_ < CAPACITY) size_++;
+    }
+
+    size_t size() const { return size_; }
+
+    position operator[](size_t index) const
+    {
+        return positions_[(newest_ + index) % CAPACITY];
+    }
+};
+
+class Entity {
+
+    friend class World;
+
+private:
+
+    int health_;
+    int attack_;
+    int defense_;
+    string name_;
+    position entityPosition_;
+
+    MoveHistory lastPositions_;
+
+    char sprite_;
+
+    // Set once the entity is owned by a world, used to keep
+    // the world's spatial index in sync with our position.
+    World* world_ = nullptr;
+    uint32_t slot_ = 0;
+
+    void notifyMove(position from, position to);
+
+    int evaluateDamage(int damage)
+    {
+        return health_ - damage;
+    }
+
+    void push_move(position pos)
+    {
+        lastPositions_.push(pos);
+    }
+
+public:
+
+    enum class ENTYPE {
+        ENEMY,
+        PLAYER
+    };
+
+    ENTYPE entityType_;
+
+    Entity(string Name, int Health, int Attack, int Defense, position Position,
+            char Sprite) :
+        name_{Name},
+        health_{Health},
+        attack_{Attack}, 
+        defense_{Defense},
+        entityPosition_ {Position},
+        sprite_ {Sprite} {}
+
+    const MoveHistory& getLastPositions() const { return lastPositions_; }
+
+    static position clampPosition(position Position, limits worldLimits)
+    {
+        position res;
+
+        if(Position.first >= worldLimits.first)        
+            res.first = worldLimits.first - 1;
+        else if(Position.first <= 0)
+            res.first = 0;
+        else
+            res.first = Position.first;
+
+        if(Position.second >= worldLimits.second)        
+            res.second = worldLimits.second - 1;
+        else if(Position.second <= 0)
+            res.second = 0;
+        else
+            res.second = Position.second;
+
+        return res;
+    }
+
+    void setPosition(position Position, limits worldLimits) 
+    {
+        position res = clampPosition(Position, worldLimits);
+
+        notifyMove(entityPosition_, res);
+        entityPosition_ = res; 
+        push_move(res);
+    } 
+
+    void setHealth(int health)
+    {
+        health_ = health;
+    }
+
+    void receiveDamage(int damage);
+
+    const string& getName() const { return name_; }
+    position getPosition() { return entityPosition_; }
+    char getSprite() { return sprite_; }
+    int getHealth() { return health_; }
+    int getAttack() { return attack_; }
+    int getDefense() { return defense_; }
+    uint32_t getSlot() const { return slot_; }
+
+    virtual ~Entity() = default;
+};
+
+// Player attacks are shapes laid out facing up and turned to face
+// where they're thrown. Cells are ordered by distance, and each one
+// names its parent, the cell one step back towards the player (-1 is
+// the player). A cell only lands when it's open and its parent
+// landed, so a wall shadows whatever is behind it.
+enum class Facing : uint8_t { UP, DOWN, LEFT, RIGHT };
+
+struct PatternCell
+{
+    int8_t row;
+    int8_t column;
+    int16_t parent;
+};
+
+struct AttackPattern
+{
+    string_view name;
+    array<char, 4> sprites;     // by Facing
+    int range;
+    bool directional;
+    const PatternCell* cells;
+    size_t count;
+};
+
+constexpr int patternAbs(int value)
+{
+    return value < 0 ? -value : value;
+}
+
+constexpr int patternSign(int value)
+{
+    return (value > 0) - (value < 0);
+}
+
+// Every cell within range (by the larger axis) that inside accepts.
+// A parent is one step closer on the larger axis, or both on a
+// diagonal, so it always comes earlier. -2 marks a missing one.
+template<size_t N, class Inside>
+constexpr array<PatternCell, N> buildPattern(int range, Inside inside)
+{
+    array<PatternCell, N> cells{};
+    size_t count = 0;
+    for(int ring = 1; ring <= range; ring++)
+    {
+        for(int row = -ring; row <= ring; row++)
+        {
+            for(int column = -ring; column <= ring; column++)
+            {
+                if(max(patternAbs(row), patternAbs(column)) != ring || !inside(row, column))
+                    continue;
+                if(count == N)
+                    return {};
+
+                int parentRow = patternAbs(row) >= patternAbs(column) ? row - patternSign(row) : row;
+                int parentColumn = patternAbs(column) >= patternAbs(row) ? column - patternSign(column) : column;
+                int16_t parent = parentRow == 0 && parentColumn == 0 ? -1 : -2;
+                for(size_t i = 0; i < count && parent == -2; i++)
+                {
+                    if(cells[i].row == parentRow && cells[i].column == parentColumn)
+                        parent = static_cast<int16_t>(i);
+                }
+
+                cells[count++] = { static_cast<int8_t>(row), static_cast<int8_t>(column), parent };
+            }
+        }
+    }
+    return cells;
+}
+
+template<size_t N>
+constexpr bool patternIsWhole(const array<PatternCell, N>& cells)
+{
+    for(auto& cell : cells)
+    {
+        if(cell.parent == -2 || (cell.row == 0 && cell.column == 0))
+            return false;
+    }
+    return true;
+}
+
+constexpr int SWING_RANGE = 2;
+constexpr int CONE_RANGE  = 12;
+constexpr int BURST_RANGE = 10;
+
+constexpr auto swingCells = buildPattern<SWING_RANGE>(SWING_RANGE,
+        [](int row, int column) { return row < 0 && column == 0; });
+constexpr auto coneCells = buildPattern<CONE_RANGE * CONE_RANGE + 2 * CONE_RANGE>(CONE_RANGE,
+        [](int row, int column) { return row < 0 && patternAbs(column) <= -row; });
+constexpr auto burstCells = buildPattern<2 * BURST_RANGE * (BURST_RANGE + 1)>(BURST_RANGE,
+        [](int row, int column) { return patternAbs(row) + patternAbs(column) <= BURST_RANGE; });
+
+static_assert(patternIsWhole(swingCells) && patternIsWhole(coneCells) && patternIsWhole(burstCells),
+        "an attack pattern has a cell without a parent or is the wrong size");
+
+constexpr AttackPattern SWING = { "swing", {{ '|', '|', '\\', '/' }}, SWING_RANGE, true,
+    swingCells.data(), swingCells.size() };
+constexpr AttackPattern CONE  = { "cone",  {{ '~', '~', '~', '~' }}, CONE_RANGE, true,
+    coneCells.data(), coneCells.size() };
+constexpr AttackPattern BURST = { "burst", {{ 'o', 'o', 'o', 'o' }}, BURST_RANGE, false,
+    burstCells.data(), burstCells.size() };
+
+// Room for the cells of any one attack.
+constexpr size_t MAX_ATTACK_CELLS = max({ SWING.count, CONE.count, BURST.count });
+
+constexpr position rotateOffset(int row, int column, Facing facing)
+{
+    switch(facing)
+    {
+        case Facing::DOWN:  return position(-row, -column);
+        case Facing::LEFT:  return position(-column, row);
+        case Facing::RIGHT: return position(column, -row);
+        default:            return position(row, column);
+    }
+}
+
+using attacks = vector< pair<char, position> >;
+
+class Player : public Entity {
+
+    friend class World;
+
+private:
+    attacks attackPositions_;
+    EntityId lastAttackedEnemy = 0;
+
+public:
+    Player(string Name, int Health, int Attack, int Defense, position Position,
+            char Sprite)
+    : Entity(Name, Health, Attack, Defense, Position, Sprite) {
+        entityType_ = ENTYPE::PLAYER;
+        attackPositions_.reserve(MAX_ATTACK_CELLS);
+    }
+
+    // The world keeps a copy, it needs the room for attacks too.
+    Player(const Player& other)
+    : Entity(other), lastAttackedEnemy(other.lastAttackedEnemy) {
+        attackPositions_.reserve(MAX_ATTACK_CELLS);
+        attackPositions_ = other.attackPositions_;
+    }
+
+    void moveBackOnePosition(World & world);
+
+    void drawStatus(ostream& out = cout)
+    {
+        out << endl;
+        out << this->getName() + "'s  Status \n"; 
+        out << "    Health  : " + to_string( this->getHealth()) << endl;
+        out << "    Attack  : " + to_string( this->getAttack()) << endl;
+        out << "    Defense : " + to_string( this->getDefense()) << endl;
+    };
+
+    void attack(const AttackPattern& pattern, Facing facing, World & world);
+
+    void pushAttack(char attack, position pos)
+    {
+        attackPositions_.push_back( pair(attack, pos) );
+    } 
+
+    void checkCollisions(World& world);
+
+    auto getLastAttackedEnemy()
+    {
+        return lastAttackedEnemy;
+    }
+
+    void setLastAttackedEnemy(EntityId lastAttacked)
+    {
+        lastAttackedEnemy = lastAttacked;
+    }
+
+    void clearAttack()
+    {
+        attackPositions_.clear();
+    }
+
+    const attacks& getAttackPositions() const
+    {
+        return attackPositions_;
+    }
+
+};
+
+enum class ENEMY_TYPE : uint8_t {
+    BLIND_BAT,
+    HOUND,
+};
+
+constexpr size_t ENEMY_TYPE_COUNT = 2;
+
+// Enemy ids are generational handles laid out as
+//   [type : 4][generation : 28][index : 32]
+// The type says which pool the enemy lives in, the index picks its
+// entry in that pool's handle table and the generation tells a live
+// enemy from an old one that had the same entry. 0 is never valid.
+constexpr int ENEMY_ID_TYPE_SHIFT       = 60;
+constexpr int ENEMY_ID_GENERATION_SHIFT = 32;
+constexpr EntityId ENEMY_ID_INDEX_MASK      = 0xffffffffull;
+constexpr EntityId ENEMY_ID_GENERATION_MASK = 0x0fffffffull;
+
+constexpr ENEMY_TYPE enemyTypeOf(EntityId id)
+{
+    return static_cast<ENEMY_TYPE>(id >> ENEMY_ID_TYPE_SHIFT);
+}
+
+constexpr uint32_t handleIndexOf(EntityId id)
+{
+    return static_cast<uint32_t>(id & ENEMY_ID_INDEX_MASK);
+}
+
+constexpr uint32_t handleGenerationOf(EntityId id)
+{
+    return static_cast<uint32_t>((id >> ENEMY_ID_GENERATION_SHIFT) & ENEMY_ID_GENERATION_MASK);
+}
+
+using Scene = std::vector< std::string >;
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "entity.h"
+
+// Enemies of one type are kept as parallel arrays so the per turn
+// systems walk contiguous memory instead of chasing pointers.
+// Removal swaps the last enemy into the freed slot, ids stay
+// stable and are what other code should hold on to. An id goes
+// through the handle table to the slot, removing bumps the entry's
+// generation so ids of dead enemies stop resolving, and the entry
+// is reused from the free list.
+struct EntityStore
+{
+    vector<position> positions;
+    vector<int> health;
+    vector<int> attack;
+    vector<int> defense;
+    vector<char> sprites;
+    vector<position> homes;
+    vector<EntityId> ids;
+
+    // By handle index.
+    vector<uint32_t> slotOfHandle;
+    vector<uint32_t> generations;
+    vector<uint32_t> freeHandles;
+
+    unordered_map<EntityId, string> names;
+
+    // The type part of every id handed out.
+    EntityId typeBits = 0;
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    size_t size() const { return ids.size(); }
+
+    EntityId makeId(uint32_t index) const
+    {
+        return typeBits | static_cast<EntityId>(generations[index]) << ENEMY_ID_GENERATION_SHIFT | index;
+    }
+
+    size_t add(const string& name, int healthValue, int attackValue, int defenseValue,
+            char sprite, position pos)
+    {
+        uint32_t index;
+        if(!freeHandles.empty())
+        {
+            index = freeHandles.back();
+            freeHandles.pop_back();
+        }
+        else
+        {
+            index = static_cast<uint32_t>(generations.size());
+            generations.push_back(1);
+            slotOfHandle.push_back(0);
+            // Every handle can end up free, so removing never allocates.
+            freeHandles.reserve(generations.capacity());
+        }
+        slotOfHandle[index] = static_cast<uint32_t>(ids.size());
+        EntityId id = makeId(index);
+
+        positions.push_back(pos);
+        health.push_back(healthValue);
+        attack.push_back(attackValue);
+        defense.push_back(defenseValue);
+        sprites.push_back(sprite);
+        homes.push_back(pos);
+        ids.push_back(id);
+
+        if(!name.empty())
+            names[id] = name;
+
+        return ids.size() - 1;
+    }
+
+    // Returns the old index of the enemy that was moved into slot,
+    // or npos when slot was the last one.
+    size_t remove(size_t slot)
+    {
+        size_t last = size() - 1;
+
+        uint32_t index = handleIndexOf(ids[slot]);
+        generations[index] = max<uint32_t>(1, (generations[index] + 1) & ENEMY_ID_GENERATION_MASK);
+        freeHandles.push_back(index);
+        names.erase(ids[slot]);
+
+        if(slot != last)
+        {
+            positions[slot] = positions[last];
+            health[slot]    = health[last];
+            attack[slot]    = attack[last];
+            defense[slot]   = defense[last];
+            sprites[slot]   = sprites[last];
+            homes[slot]     = homes[last];
+            ids[slot]       = ids[last];
+            slotOfHandle[handleIndexOf(ids[slot])] = static_cast<uint32_t>(slot);
+        }
+
+        positions.pop_back();
+        health.pop_back();
+        attack.pop_back();
+        defense.pop_back();
+        sprites.pop_back();
+        homes.pop_back();
+        ids.pop_back();
+
+        return slot != last ? last : npos;
+    }
+
+    // npos for ids of other types, dead enemies and garbage.
+    size_t find(EntityId id) const
+    {
+        uint32_t index = handleIndexOf(id);
+        if((id & ~(ENEMY_ID_GENERATION_MASK << ENEMY_ID_GENERATION_SHIFT | ENEMY_ID_INDEX_MASK)) != typeBits
+                || index >= generations.size() || generations[index] != handleGenerationOf(id))
+            return npos;
+        return slotOfHandle[index];
+    }
+
+    // Rebuilds the slots from ids after they were read back, false
+    // when the handle table doesn't agree with them.
+    bool linkHandles()
+    {
+        constexpr uint32_t UNUSED = static_cast<uint32_t>(-1);
+        slotOfHandle.assign(generations.size(), UNUSED);
+
+        for(size_t slot = 0; slot < ids.size(); slot++)
+        {
+            uint32_t index = handleIndexOf(ids[slot]);
+            if(index >= generations.size() || makeId(index) != ids[slot]
+                    || slotOfHandle[index] != UNUSED)
+                return false;
+            slotOfHandle[index] = static_cast<uint32_t>(slot);
+        }
+
+        for(uint32_t index : freeHandles)
+        {
+            if(index >= generations.size() || slotOfHandle[index] != UNUSED)
+                return false;
+            slotOfHandle[index] = 0;
+        }
+        freeHandles.reserve(generations.capacity());
+        return ids.size() + freeHandles.size() == generations.size();
+    }
+
+    string getName(size_t slot) const
+    {
+        auto it = names.find(ids[slot]);
+        return it == names.end() ? string() : it->second;
+    }
+};
@@ -0,0 +1,250 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "entity.h"
+
+// Combat events. Actors and targets are enemy ids, or player ids
+// (PLAYER_ID_TYPE in the type bits, the player's slot below).
+enum class EventKind : uint8_t
+{
+    DAMAGE,     // amount dealt, left is the target's health after it
+    REMOVED,    // target left the world
+    MOVE,       // actor went from (row, column) to (toRow, toColumn)
+    ATTACK,     // amount is cells that landed, left is targets in them
+};
+
+constexpr EntityId PLAYER_ID_TYPE = 0xf;
+
+constexpr EntityId playerEventId(size_t slot)
+{
+    return PLAYER_ID_TYPE << ENEMY_ID_TYPE_SHIFT | slot;
+}
+
+struct CombatEvent
+{
+    uint64_t turn;
+    EntityId actor;
+    EntityId target;
+    int32_t row;
+    int32_t column;
+    int32_t toRow;
+    int32_t toColumn;
+    int32_t amount;
+    int32_t left;
+    EventKind kind;
+    uint8_t padding[7];
+};
+
+static_assert(sizeof(CombatEvent) == 56, "combat event layout changed");
+
+// Single producer, single consumer ring. Each side owns one index
+// and keeps a copy of the other one, the shared indices are only
+// read when the copy says the ring looks full or empty. A full ring
+// drops the event and counts it, the producer never waits.
+class EventRing
+{
+
+private:
+
+    unique_ptr<CombatEvent[]> events_;
+    size_t mask_;
+
+    alignas(64) atomic<size_t> head_ {0};   // next write, producer's
+    size_t cachedTail_ = 0;
+    atomic<size_t> dropped_ {0};
+
+    alignas(64) atomic<size_t> tail_ {0};   // next read, consumer's
+    size_t cachedHead_ = 0;
+
+public:
+
+    // capacity is rounded up to a power of two.
+    explicit EventRing(size_t capacity)
+    {
+        size_t size = 1;
+        while(size < capacity)
+            size <<= 1;
+        events_.reset(new CombatEvent[size]);
+        mask_ = size - 1;
+    }
+
+    bool push(const CombatEvent& event)
+    {
+        size_t head = head_.load(memory_order_relaxed);
+        if(head - cachedTail_ > mask_)
+        {
+            cachedTail_ = tail_.load(memory_order_acquire);
+            if(head - cachedTail_ > mask_)
+            {
+                dropped_.store(dropped_.load(memory_order_relaxed) + 1, memory_order_relaxed);
+                return false;
+            }
+        }
+        events_[head & mask_] = event;
+        head_.store(head + 1, memory_order_release);
+        return true;
+    }
+
+    // Copies up to count events out, returns how many.
+    size_t pop(CombatEvent* out, size_t count)
+    {
+        size_t tail = tail_.load(memory_order_relaxed);
+        if(cachedHead_ == tail)
+            cachedHead_ = head_.load(memory_order_acquire);
+
+        size_t taken = min(count, cachedHead_ - tail);
+        for(size_t i = 0; i < taken; i++)
+            out[i] = events_[(tail + i) & mask_];
+        tail_.store(tail + taken, memory_order_release);
+        return taken;
+    }
+
+    size_t getDropped() const
+    {
+        return dropped_.load(memory_order_relaxed);
+    }
+};
+
+// Drains a ring into a file on its own thread, as raw records after
+// an EVENT_MAGIC header or as one line per event. The game thread
+// only ever pushes into the ring.
+constexpr char EVENT_MAGIC[8] = { 'T', 'T', 'R', 'P', 'G', 'E', 'V', 'T' };
+constexpr uint32_t EVENT_VERSION = 1;
+
+class EventLog
+{
+
+private:
+
+    static constexpr size_t BATCH = 1024;
+
+    EventRing ring_;
+    FILE* file_ = nullptr;
+    bool binary_;
+    atomic<bool> stopping_ {false};
+    thread writer_;
+    size_t written_ = 0;
+    bool failed_ = false;
+
+    static constexpr const char* kindNames_[] = { "damage", "removed", "move", "attack" };
+
+    static void printId(FILE* file, EntityId id)
+    {
+        EntityId type = id >> ENEMY_ID_TYPE_SHIFT;
+        if(type == PLAYER_ID_TYPE)
+            fprintf(file, "player %u", static_cast<unsigned>(id & ENEMY_ID_INDEX_MASK));
+        else
+            fprintf(file, "%c%u.%u", type == static_cast<EntityId>(ENEMY_TYPE::HOUND) ? 'H' : 'B',
+                    handleIndexOf(id), handleGenerationOf(id));
+    }
+
+    void writeText(const CombatEvent& event)
+    {
+        fprintf(file_, "%llu %s ", static_cast<unsigned long long>(event.turn),
+                kindNames_[static_cast<size_t>(event.kind)]);
+        printId(file_, event.actor);
+        switch(event.kind)
+        {
+            case EventKind::DAMAGE:
+                fputs(" -> ", file_);
+                printId(file_, event.target);
+                fprintf(file_, " %d (%d left) at %d,%d\n", event.amount, event.left, event.row, event.column);
+                break;
+            case EventKind::REMOVED:
+                fprintf(file_, " at %d,%d\n", event.row, event.column);
+                break;
+            case EventKind::MOVE:
+                fprintf(file_, " %d,%d -> %d,%d\n", event.row, event.column, event.toRow, event.toColumn);
+                break;
+            case EventKind::ATTACK:
+                fprintf(file_, " from %d,%d, %d cells, %d targets\n", event.row, event.column,
+                        event.amount, event.left);
+                break;
+        }
+    }
+
+    size_t drain(CombatEvent* batch)
+    {
+        size_t count = ring_.pop(batch, BATCH);
+        if(binary_)
+            fwrite(batch, sizeof(CombatEvent), count, file_);
+        else
+        {
+            for(size_t i = 0; i < count; i++)
+                writeText(batch[i]);
+        }
+        written_ += count;
+        return count;
+    }
+
+    // Backs off while the ring is empty, never touches the producer.
+    void writerLoop()
+    {
+        unique_ptr<CombatEvent[]> batch(new CombatEvent[BATCH]);
+        auto idle = chrono::microseconds(50);
+        while(!stopping_.load(memory_order_acquire))
+        {
+            if(drain(batch.get()) > 0)
+            {
+                idle = chrono::microseconds(50);
+                continue;
+            }
+            this_thread::sleep_for(idle);
+            idle = min(idle * 2, chrono::microseconds(5000));
+        }
+        while(drain(batch.get()) > 0)
+            ;
+    }
+
+public:
+
+    EventLog(size_t capacity, bool binary) : ring_(capacity), binary_(binary) {}
+
+    ~EventLog()
+    {
+        close();
+    }
+
+    EventLog(const EventLog&) = delete;
+    EventLog& operator=(const EventLog&) = delete;
+
+    bool open(const string& path)
+    {
+        file_ = fopen(path.c_str(), binary_ ? "wb" : "w");
+        if(!file_)
+            return false;
+
+        if(binary_)
+        {
+            uint32_t header[2] = { EVENT_VERSION, static_cast<uint32_t>(sizeof(CombatEvent)) };
+            fwrite(EVENT_MAGIC, sizeof(EVENT_MAGIC), 1, file_);
+            fwrite(header, sizeof(header), 1, file_);
+        }
+        writer_ = thread(&EventLog::writerLoop, this);
+        return true;
+    }
+
+    // Stops the writer once everything pushed so far is written.
+    bool close()
+    {
+        if(!file_)
+            return !failed_;
+
+        stopping_.store(true, memory_order_release);
+        writer_.join();
+        failed_ = ferror(file_) != 0;
+        failed_ |= fclose(file_) != 0;
+        file_ = nullptr;
+        return !failed_;
+    }
+
+    void push(const CombatEvent& event)
+    {
+        ring_.push(event);
+    }
+
+    size_t getWritten() const { return written_; }
+    size_t getDropped() const { return ring_.getDropped(); }
+};
@@ -0,0 +1,210 @@
+#pragma once
+
+#include "collision_mask.h"
+
+// What one player sees, by symmetric shadowcasting out to RADIUS over
+// the collision mask: walls are seen, what's behind them isn't, and a
+// cell sees the origin exactly when the origin sees it. Visible cells
+// are bits over the square around the origin, so a sight costs the
+// same on any map, and they're only worked out again when the origin
+// moves or a blocker inside the square changes. Cells ever seen are
+// remembered per chunk, so that memory follows what was explored.
+class FieldOfView
+{
+
+public:
+
+    static constexpr int RADIUS = 12;
+    static constexpr int SIDE   = 2 * RADIUS + 1;
+
+private:
+
+    static constexpr int SHIFT = ChunkedMap::CHUNK_SHIFT;
+    static constexpr int MASK  = ChunkedMap::CHUNK_MASK;
+
+    // Depth out from the origin, between two slopes kept as
+    // fractions so the scan is exact.
+    struct Row
+    {
+        int depth;
+        int startNumerator, startDenominator;
+        int endNumerator, endDenominator;
+    };
+
+    position origin_ {0, 0};
+    limits limits_ {0, 0};
+    bool valid_ = false;
+    array<uint64_t, (SIDE * SIDE + 63) / 64> visible_ {};
+
+    unordered_map<uint64_t, CollisionMask::Rows> explored_;
+    uint64_t lastChunk_ = ~0ull;
+    CollisionMask::Rows* lastRows_ = nullptr;
+
+    vector<Row> rows_;
+    size_t updates_ = 0;
+
+    static int floorDiv(int a, int b)
+    {
+        return a >= 0 ? a / b : -((-a + b - 1) / b);
+    }
+
+    static uint64_t chunkKey(int row, int column)
+    {
+        return static_cast<uint64_t>(row >> SHIFT) << 32 | static_cast<uint32_t>(column >> SHIFT);
+    }
+
+    // Quadrants look up, down, right and left, column runs across.
+    position cellAt(int quadrant, int depth, int column) const
+    {
+        switch(quadrant)
+        {
+            case 0:  return position(origin_.first - depth, origin_.second + column);
+            case 1:  return position(origin_.first + depth, origin_.second + column);
+            case 2:  return position(origin_.first + column, origin_.second + depth);
+            default: return position(origin_.first + column, origin_.second - depth);
+        }
+    }
+
+    void reveal(position pos)
+    {
+        int row = pos.first - origin_.first;
+        int column = pos.second - origin_.second;
+        if(row * row + column * column > RADIUS * RADIUS + RADIUS
+                || pos.first < 0 || pos.first >= limits_.first
+                || pos.second < 0 || pos.second >= limits_.second)
+            return;
+
+        size_t bit = static_cast<size_t>((row + RADIUS) * SIDE + column + RADIUS);
+        visible_[bit >> 6] |= 1ull << (bit & 63);
+
+        uint64_t chunk = chunkKey(pos.first, pos.second);
+        if(chunk != lastChunk_)
+        {
+            lastChunk_ = chunk;
+            lastRows_  = &explored_[chunk];
+        }
+        (*lastRows_)[pos.first & MASK] |= 1ull << (pos.second & MASK);
+    }
+
+    // Rows of a quadrant are scanned from a stack instead of by
+    // recursion, each open stretch before a wall starts a new row.
+    void scan(const CollisionMask& mask, int quadrant)
+    {
+        rows_.clear();
+        rows_.push_back({ 1, -1, 1, 1, 1 });
+        while(!rows_.empty())
+        {
+            Row row = rows_.back();
+            rows_.pop_back();
+            if(row.depth > RADIUS)
+                continue;
+
+            // Ties round towards the middle of the row.
+            int first = floorDiv(2 * row.depth * row.startNumerator + row.startDenominator,
+                    2 * row.startDenominator);
+            int last  = -floorDiv(row.endDenominator - 2 * row.depth * row.endNumerator,
+                    2 * row.endDenominator);
+
+            // -1 before the first cell, then whether the last one was a wall.
+            int previous = -1;
+            for(int column = first; column <= last; column++)
+            {
+                position pos = cellAt(quadrant, row.depth, column);
+                bool wall = mask.isBlocked(pos);
+                bool symmetric = column * row.startDenominator >= row.depth * row.startNumerator
+                    && column * row.endDenominator <= row.depth * row.endNumerator;
+                if(wall || symmetric)
+                    reveal(pos);
+
+                if(previous == 1 && !wall)
+                {
+                    row.startNumerator   = 2 * column - 1;
+                    row.startDenominator = 2 * row.depth;
+                }
+                if(previous == 0 && wall)
+                {
+                    Row next = row;
+                    next.depth++;
+                    next.endNumerator   = 2 * column - 1;
+                    next.endDenominator = 2 * row.depth;
+                    rows_.push_back(next);
+                }
+                previous = wall;
+            }
+
+            if(previous == 0)
+            {
+                Row next = row;
+                next.depth++;
+                rows_.push_back(next);
+            }
+        }
+    }
+
+public:
+
+    void invalidate()
+    {
+        valid_ = false;
+    }
+
+    // Whether pos is in the square the visible bits cover.
+    bool covers(position pos) const
+    {
+        return abs(pos.first - origin_.first) <= RADIUS && abs(pos.second - origin_.second) <= RADIUS;
+    }
+
+    // Works the visible cells out again if origin moved or something
+    // changed since the last time, true when it did.
+    bool update(position origin, const CollisionMask& mask, limits worldLimits)
+    {
+        if(valid_ && origin == origin_ && worldLimits == limits_)
+            return false;
+
+        origin_ = origin;
+        limits_ = worldLimits;
+        valid_  = true;
+        visible_.fill(0);
+
+        reveal(origin);
+        for(int quadrant = 0; quadrant < 4; quadrant++)
+            scan(mask, quadrant);
+        updates_++;
+        return true;
+    }
+
+    bool isVisible(position pos) const
+    {
+        if(!covers(pos))
+            return false;
+        size_t bit = static_cast<size_t>((pos.first - origin_.first + RADIUS) * SIDE
+                + pos.second - origin_.second + RADIUS);
+        return visible_[bit >> 6] >> (bit & 63) & 1;
+    }
+
+    bool wasSeen(position pos) const
+    {
+        auto chunk = explored_.find(chunkKey(pos.first, pos.second));
+        return chunk != explored_.end() && (chunk->second[pos.first & MASK] >> (pos.second & MASK) & 1);
+    }
+
+    // Blanks the cells of a row that were never seen, one chunk
+    // lookup per chunk the run crosses.
+    void hideUnseen(int row, int column, int length, char* cells) const
+    {
+        int end = column + length;
+        while(column < end)
+        {
+            int chunkEnd = min(end, (column | MASK) + 1);
+            auto chunk = row >= 0 && column >= 0 ? explored_.find(chunkKey(row, column)) : explored_.end();
+            uint64_t seen = chunk != explored_.end() ? chunk->second[row & MASK] : 0;
+            for(; column < chunkEnd; column++, cells++)
+            {
+                if(!(seen >> (column & MASK) & 1))
+                    *cells = ' ';
+            }
+        }
+    }
+
+    size_t getUpdateCount() const { return updates_; }
+};
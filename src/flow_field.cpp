@@ -0,0 +1,63 @@
+#include "flow_field.h"
+#include "snapshot.h"
+#include "world.h"
+
+void FlowField::write(SnapshotWriter& writer) const
+{
+    writer.value<uint8_t>(valid_);
+    if(!valid_)
+        return;
+    writer.value(limits_);
+    writer.value(offset_);
+    writer.value<int32_t>(incrementalUpdates_);
+    writer.value<uint8_t>(complete_);
+    writer.array(sources_);
+    writer.value<uint64_t>(used_);
+    for(size_t slot = 0; slot < used_; slot++)
+    {
+        const Chunk& chunk = *chunks_[slot];
+        writer.value(chunk.index);
+        writer.value(chunk.cost);
+        writer.value(chunk.open);
+    }
+}
+
+bool FlowField::read(SnapshotReader& reader)
+{
+    valid_ = reader.value<uint8_t>() != 0;
+    if(!valid_)
+        return reader.ok();
+
+    limits worldLimits = reader.value<limits>();
+    offset_ = reader.value<int32_t>();
+    incrementalUpdates_ = reader.value<int32_t>();
+    complete_ = reader.value<uint8_t>() != 0;
+    reader.array(sources_);
+    uint64_t used = reader.value<uint64_t>();
+
+    int maxSide = static_cast<int>(World::WORLD_CONSTANTS::MAX_WORLD_SIDE);
+    if(!reader.ok() || worldLimits.first <= 0 || worldLimits.second <= 0
+            || worldLimits.first > maxSide || worldLimits.second > maxSide)
+        return false;
+    setLimits(worldLimits);
+    if(used > chunkOf_.size())
+        return false;
+
+    for(uint64_t slot = 0; slot < used; slot++)
+    {
+        uint32_t index = reader.value<uint32_t>();
+        if(!reader.ok() || index >= chunkOf_.size() || chunkOf_[index] != NO_CHUNK)
+            return false;
+
+        if(used_ == chunks_.size())
+            chunks_.push_back(make_unique<Chunk>());
+        Chunk& chunk = *chunks_[used_];
+        chunk.index = index;
+        reader.bytes(chunk.cost.data(), sizeof(chunk.cost));
+        reader.bytes(chunk.open.data(), sizeof(chunk.open));
+        chunk.goals.fill(0);
+        chunkOf_[index] = static_cast<uint32_t>(used_++);
+    }
+    goalsLeft_ = 0;
+    return reader.ok();
+}
@@ -0,0 +1,384 @@
+#pragma once
+
+#include "collision_mask.h"
+
+// Step counts to the nearest player, moves in 8 directions.
+// Anything chasing a player just walks to the neighbour with the
+// lowest cost.
+//
+// Costs are kept in the same 64x64 chunks as the terrain, a chunk
+// is only made once the search gets to it. A rebuild searches out
+// from the players until every goal, the cells the chasers stand
+// on, has its cost or there is nothing reachable left. It covers
+// as much of the map as the chasers need, however far off and
+// whatever way round the walls they are.
+//
+// When every player moved a step or two the old costs plus the
+// step are still upper bounds, so instead of starting over a
+// global offset is bumped and a wave only lowers what the new
+// positions made closer, over cells the last rebuild reached and
+// only so far out. Cells it doesn't reach may overestimate for a
+// while, but every cell still has a cheaper neighbour until a
+// player is reached.
+// A full rebuild clears that out every few turns, and whenever a
+// goal wandered out of what was searched or the terrain changes.
+class FlowField
+{
+
+public:
+
+    static constexpr int32_t UNREACHED = INT32_MAX;
+    static constexpr int MAX_INCREMENTAL = 64;
+    // Cells an incremental update may lower, the ones closest to
+    // the players first.
+    static constexpr size_t MAX_WAVE = 1 << 12;
+
+private:
+
+    static constexpr int SHIFT = ChunkedMap::CHUNK_SHIFT;
+    static constexpr int SIZE  = ChunkedMap::CHUNK_SIZE;
+    static constexpr int MASK  = ChunkedMap::CHUNK_MASK;
+    static constexpr uint32_t NO_CHUNK = UINT32_MAX;
+
+    struct Chunk
+    {
+        uint32_t index = 0;
+        // Real cost is cost + offset_, except for UNREACHED.
+        array<int32_t, SIZE * SIZE> cost;
+        // Passability, read once when the chunk is made.
+        array<uint64_t, SIZE> open;
+        // Goals the running search hasn't got to yet.
+        array<uint64_t, SIZE> goals;
+    };
+
+    limits limits_ {0, 0};
+    int chunkColumns_ = 0;
+
+    // By chunk, NO_CHUNK until the search gets there. The first
+    // used_ chunks are live, the rest are kept to be reused.
+    vector<uint32_t> chunkOf_;
+    vector< unique_ptr<Chunk> > chunks_;
+    size_t used_ = 0;
+
+    int32_t offset_ = 0;
+    vector<position> frontier_;
+    vector<position> sources_;
+
+    size_t goalsLeft_ = 0;
+    // The last rebuild ran out of cells, whatever it didn't reach
+    // can't be reached at all.
+    bool complete_ = false;
+
+    bool valid_ = false;
+    int incrementalUpdates_ = 0;
+    size_t lastUpdateCells_ = 0;
+
+    bool inWorld(position pos) const
+    {
+        return pos.first >= 0 && pos.first < limits_.first
+            && pos.second >= 0 && pos.second < limits_.second;
+    }
+
+    size_t chunkIndex(position pos) const
+    {
+        return static_cast<size_t>(pos.first >> SHIFT) * chunkColumns_ + (pos.second >> SHIFT);
+    }
+
+    // Null when the search never got there.
+    Chunk* chunkAt(position pos) const
+    {
+        uint32_t slot = chunkOf_[chunkIndex(pos)];
+        return slot == NO_CHUNK ? nullptr : chunks_[slot].get();
+    }
+
+    template<class Passable>
+    Chunk& make(position pos, Passable& passable)
+    {
+        if(Chunk* chunk = chunkAt(pos))
+            return *chunk;
+
+        if(used_ == chunks_.size())
+            chunks_.push_back(make_unique<Chunk>());
+        Chunk& chunk = *chunks_[used_];
+        chunk.index = static_cast<uint32_t>(chunkIndex(pos));
+        chunkOf_[chunk.index] = static_cast<uint32_t>(used_++);
+
+        chunk.cost.fill(UNREACHED);
+        chunk.goals.fill(0);
+        int top  = pos.first & ~MASK;
+        int left = pos.second & ~MASK;
+        for(int row = 0; row < SIZE; row++)
+        {
+            uint64_t bits = 0;
+            for(int column = 0; column < SIZE; column++)
+            {
+                position cell(top + row, left + column);
+                if(inWorld(cell) && passable(cell))
+                    bits |= 1ull << column;
+            }
+            chunk.open[row] = bits;
+        }
+        return chunk;
+    }
+
+    static int32_t& costOf(Chunk& chunk, position pos)
+    {
+        return chunk.cost[(pos.first & MASK) * SIZE + (pos.second & MASK)];
+    }
+
+    static bool isOpen(const Chunk& chunk, position pos)
+    {
+        return chunk.open[pos.first & MASK] >> (pos.second & MASK) & 1;
+    }
+
+    // Takes the goal off a cell the search just got to.
+    void reach(Chunk& chunk, position pos)
+    {
+        uint64_t bit = 1ull << (pos.second & MASK);
+        uint64_t& goals = chunk.goals[pos.first & MASK];
+        if(goals & bit)
+        {
+            goals &= ~bit;
+            goalsLeft_--;
+        }
+    }
+
+    // Lowers one neighbour of a cell reached at reached - 1.
+    void lower(Chunk& chunk, position pos, int32_t reached, bool grow)
+    {
+        if(!isOpen(chunk, pos))
+            return;
+        int32_t& cost = costOf(chunk, pos);
+        if(reached >= cost || (!grow && cost == UNREACHED))
+            return;
+        if(cost == UNREACHED)
+            reach(chunk, pos);
+        cost = reached;
+        frontier_.push_back(pos);
+    }
+
+    // Breadth first from whatever is in frontier_, only ever lowers.
+    // Growing, it makes chunks as it goes and stops at the last
+    // goal. Otherwise it stays on cells that were already reached
+    // and stops after limit cells, what it leaves out is too high
+    // but still leads down to a player.
+    template<class Passable>
+    void spread(Passable& passable, bool grow, size_t limit = SIZE_MAX)
+    {
+        for(size_t next = 0; next < frontier_.size() && next < limit && !(grow && goalsLeft_ == 0); next++)
+        {
+            position from = frontier_[next];
+            Chunk& home = *chunkAt(from);
+            int32_t reached = costOf(home, from) + 1;
+
+            // Away from the chunk's edges every neighbour is in it.
+            int row = from.first & MASK, column = from.second & MASK;
+            bool inside = row > 0 && row < MASK && column > 0 && column < MASK;
+
+            for(int dr = -1; dr <= 1; dr++)
+            {
+                for(int dc = -1; dc <= 1; dc++)
+                {
+                    position pos(from.first + dr, from.second + dc);
+                    if(dr == 0 && dc == 0)
+                        continue;
+                    if(inside)
+                    {
+                        lower(home, pos, reached, grow);
+                        continue;
+                    }
+                    if(!inWorld(pos))
+                        continue;
+
+                    Chunk* chunk = chunkAt(pos);
+                    if(!chunk && grow)
+                        chunk = &make(pos, passable);
+                    if(chunk)
+                        lower(*chunk, pos, reached, grow);
+                }
+            }
+        }
+        if(grow)
+            complete_ = goalsLeft_ > 0;
+        lastUpdateCells_ = frontier_.size();
+    }
+
+    template<class Passable>
+    void seed(const vector<position>& sources, Passable& passable)
+    {
+        frontier_.clear();
+        for(auto source : sources)
+        {
+            if(!inWorld(source))
+                continue;
+            Chunk& chunk = make(source, passable);
+            int32_t& cost = costOf(chunk, source);
+            if(cost == UNREACHED)
+                reach(chunk, source);
+            if(cost == UNREACHED || cost + offset_ != 0)
+            {
+                cost = -offset_;
+                frontier_.push_back(source);
+            }
+        }
+    }
+
+    // Steps between two cells next to each other or one apart,
+    // or -1 when it isn't that simple.
+    template<class Passable>
+    static int shortStep(position from, position to, Passable& passable)
+    {
+        int distance = max(abs(from.first - to.first), abs(from.second - to.second));
+        if(distance <= 1)
+            return distance;
+        if(distance > 2)
+            return -1;
+
+        for(int dr = -1; dr <= 1; dr++)
+        {
+            for(int dc = -1; dc <= 1; dc++)
+            {
+                position middle(from.first + dr, from.second + dc);
+                if(max(abs(middle.first - to.first), abs(middle.second - to.second)) <= 1
+                        && passable(middle))
+                    return 2;
+            }
+        }
+        return -1;
+    }
+
+    void setLimits(limits worldLimits)
+    {
+        limits_ = worldLimits;
+        chunkColumns_ = (worldLimits.second + MASK) >> SHIFT;
+        int chunkRows = (worldLimits.first + MASK) >> SHIFT;
+        chunkOf_.assign(static_cast<size_t>(chunkRows) * chunkColumns_, NO_CHUNK);
+        used_ = 0;
+    }
+
+public:
+
+    // The next update starts from scratch.
+    void invalidate()
+    {
+        valid_ = false;
+    }
+
+    // Sources are the players, goals the cells of whatever chases
+    // them. False when no cost changed.
+    template<class Passable>
+    bool update(const vector<position>& sources, const vector<position>& goals,
+            limits worldLimits, Passable passable)
+    {
+        int step = 0;
+        bool incremental = valid_ && limits_ == worldLimits && sources.size() == sources_.size()
+            && incrementalUpdates_ < MAX_INCREMENTAL;
+        for(size_t i = 0; incremental && i < sources.size(); i++)
+        {
+            int moved = shortStep(sources_[i], sources[i], passable);
+            incremental = moved >= 0 && costAt(sources[i]) != UNREACHED;
+            step = max(step, moved);
+        }
+        for(size_t i = 0; incremental && !complete_ && i < goals.size(); i++)
+            incremental = costAt(goals[i]) != UNREACHED;
+
+        sources_ = sources;
+
+        if(incremental)
+        {
+            if(step == 0)
+            {
+                lastUpdateCells_ = 0;
+                return false;
+            }
+
+            offset_ += step;
+            incrementalUpdates_++;
+            seed(sources, passable);
+            spread(passable, false, MAX_WAVE);
+            return true;
+        }
+
+        // Chunks keep their passability until the terrain changes,
+        // only the costs start over.
+        if(!valid_ || limits_ != worldLimits)
+        {
+            for(size_t slot = 0; slot < used_; slot++)
+                chunkOf_[chunks_[slot]->index] = NO_CHUNK;
+            if(limits_ != worldLimits)
+                setLimits(worldLimits);
+            used_ = 0;
+        }
+        for(size_t slot = 0; slot < used_; slot++)
+        {
+            chunks_[slot]->cost.fill(UNREACHED);
+            chunks_[slot]->goals.fill(0);
+        }
+        offset_ = 0;
+        incrementalUpdates_ = 0;
+        valid_ = true;
+
+        goalsLeft_ = 0;
+        for(auto goal : goals)
+        {
+            if(!inWorld(goal))
+                continue;
+            Chunk& chunk = make(goal, passable);
+            uint64_t bit = 1ull << (goal.second & MASK);
+            uint64_t& bits = chunk.goals[goal.first & MASK];
+            goalsLeft_ += (bits & bit) == 0;
+            bits |= bit;
+        }
+
+        seed(sources, passable);
+        spread(passable, true);
+        return true;
+    }
+
+    int32_t costAt(position pos) const
+    {
+        if(!inWorld(pos))
+            return UNREACHED;
+        Chunk* chunk = chunkAt(pos);
+        if(!chunk)
+            return UNREACHED;
+        int32_t cost = costOf(*chunk, pos);
+        return cost == UNREACHED ? UNREACHED : cost + offset_;
+    }
+
+    // The cheapest neighbour of from, false when there is no
+    // way down from there.
+    bool nextStep(position from, position& step) const
+    {
+        int32_t best = costAt(from);
+        if(best == UNREACHED || best == 0)
+            return false;
+
+        bool found = false;
+        for(int dr = -1; dr <= 1; dr++)
+        {
+            for(int dc = -1; dc <= 1; dc++)
+            {
+                position neighbour(from.first + dr, from.second + dc);
+                int32_t cost = costAt(neighbour);
+                if(cost < best)
+                {
+                    best  = cost;
+                    step  = neighbour;
+                    found = true;
+                }
+            }
+        }
+        return found;
+    }
+
+    size_t getLastUpdateCells() const { return lastUpdateCells_; }
+
+    // Chunks the field has made so far.
+    size_t getChunkCount() const { return used_; }
+
+    // The costs depend on the updates that led to them, they're
+    // kept so a loaded world's enemies go the same way.
+    void write(SnapshotWriter& writer) const;
+    bool read(SnapshotReader& reader);
+};
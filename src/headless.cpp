@@ -0,0 +1,317 @@
+#include <fcntl.h>
+
+#include "headless.h"
+#include "journal.h"
+#include "parser.h"
+#include "player_bot.h"
+#include "setup.h"
+
+constexpr size_t EVENT_RING_SIZE = 1 << 16;
+
+unique_ptr<EventLog> openEventLog(const HeadlessOptions& options, bool& ok)
+{
+    ok = true;
+    if(options.eventsPath.empty())
+        return nullptr;
+
+    auto log = make_unique<EventLog>(EVENT_RING_SIZE, options.eventsBinary);
+    if(!log->open(options.eventsPath))
+    {
+        cerr << "Could not write " << options.eventsPath << endl;
+        ok = false;
+        return nullptr;
+    }
+    return log;
+}
+
+bool closeEventLog(EventLog* log)
+{
+    if(!log)
+        return true;
+
+    bool written = log->close();
+    cout << "events        : " << log->getWritten() << " written, "
+         << log->getDropped() << " dropped" << endl;
+    if(!written)
+        cerr << "Failed writing the event log" << endl;
+    return written;
+}
+
+bool loadCommandScript(const string& path, string& script)
+{
+    if(path == "-")
+    {
+        script.assign(istreambuf_iterator<char>(cin), istreambuf_iterator<char>());
+        return true;
+    }
+
+    ifstream file(path, ios::binary);
+    if(!file)
+        return false;
+
+    file.seekg(0, ios::end);
+    script.resize(static_cast<size_t>(file.tellg()));
+    file.seekg(0, ios::beg);
+    file.read(script.data(), script.size());
+    return true;
+}
+
+bool checkSaveRoundTrip(const World& world, const string& path)
+{
+    auto saveStart = chrono::steady_clock::now();
+    if(!world.save(path))
+    {
+        cerr << "Could not save to " << path << endl;
+        return false;
+    }
+    auto saveEnd = chrono::steady_clock::now();
+
+    World loaded{};
+    if(!loaded.load(path))
+    {
+        cerr << "Could not load " << path << endl;
+        return false;
+    }
+    auto loadEnd = chrono::steady_clock::now();
+
+    uint64_t expected = world.stateHash();
+    uint64_t actual   = loaded.stateHash();
+
+    ifstream file(path, ios::binary | ios::ate);
+    cout << "save size     : " << file.tellg() << " bytes" << endl;
+    cout << "save time     : " << chrono::duration<double, milli>(saveEnd - saveStart).count() << " ms" << endl;
+    cout << "load time     : " << chrono::duration<double, milli>(loadEnd - saveEnd).count() << " ms" << endl;
+    cout << "state hash    : " << hex << expected << " / " << actual << dec << endl;
+
+    if(expected != actual)
+    {
+        cerr << "Loaded state differs from the saved one" << endl;
+        return false;
+    }
+    return true;
+}
+
+bool runHeadless(const HeadlessOptions& options, ThreadPool& pool)
+{
+    Parser parser{};
+    PlayerBot bot{options.seed};
+
+    auto loadStart = chrono::steady_clock::now();
+    auto worldPointer = createWorld(options.levelPath, options.worldLimits,
+            options.seed, options.enemies, options.hounds, options.swoopers, options.guards);
+    if(!worldPointer)
+        return false;
+    World& world = *worldPointer;
+    world.setThreadPool(&pool);
+    world.setHistoryDepth(options.history);
+    auto loadEnd = chrono::steady_clock::now();
+
+    bool eventsOk;
+    auto events = openEventLog(options, eventsOk);
+    if(!eventsOk)
+        return false;
+    world.setEventLog(events.get());
+
+    string script;
+    bool batch = !options.batchPath.empty();
+    if(batch && !loadCommandScript(options.batchPath, script))
+    {
+        cerr << "Could not read " << options.batchPath << endl;
+        return false;
+    }
+    string_view remaining = script;
+
+    JournalWriter journal;
+    if(!options.recordPath.empty()
+            && !journal.open(options.recordPath, { options.seed, options.worldLimits,
+                options.enemies, options.hounds, options.levelPath, options.swoopers, options.guards,
+                options.history }))
+    {
+        cerr << "Could not write " << options.recordPath << endl;
+        return false;
+    }
+
+    vector<double> latencies;
+    latencies.reserve(batch ? count(script.begin(), script.end(), '\n') + 1 : options.turns);
+
+    size_t allocationsAfterWarmup = 0;
+    size_t maxTurnAllocations = 0;
+
+    long turns = 0;
+    auto start = chrono::steady_clock::now();
+    for(; batch ? !remaining.empty() : turns < options.turns; turns++)
+    {
+        auto turnStart = chrono::steady_clock::now();
+        size_t allocationsBefore = allocationCount.load(memory_order_relaxed);
+
+        // Fetched every turn, a load replaces the players.
+        auto player = world.getPlayer(0);
+
+        world.resetWorldMap();
+        player->checkCollisions(world);
+        world.EnemiesTurn();
+
+        string_view command;
+        bool keepGoing = true;
+        if(batch)
+        {
+            size_t lineEnd = remaining.find('\n');
+            command = remaining.substr(0, lineEnd);
+            if(!command.empty() && command.back() == '\r')
+                command.remove_suffix(1);
+            remaining.remove_prefix(lineEnd == string_view::npos ? remaining.size() : lineEnd + 1);
+            keepGoing = parser.parseCommand(command, world);
+        }
+        else
+        {
+            command = bot.nextCommand(world, 0);
+            parser.parseCommand(command, world);
+        }
+
+        auto turnEnd = chrono::steady_clock::now();
+        latencies.push_back(chrono::duration<double, micro>(turnEnd - turnStart).count());
+        PROFILE_END_TURN();
+
+        if(journal.isOpen())
+            journal.record(command, world.stateHash());
+
+        size_t turnAllocations = allocationCount.load(memory_order_relaxed) - allocationsBefore;
+
+        if(turns >= options.warmup)
+        {
+            allocationsAfterWarmup += turnAllocations;
+            maxTurnAllocations = max(maxTurnAllocations, turnAllocations);
+        }
+
+        if(!keepGoing)
+        {
+            turns++;
+            break;
+        }
+    }
+    auto end = chrono::steady_clock::now();
+
+    double seconds = chrono::duration<double>(end - start).count();
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies.empty() ? 0.0 : latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+    };
+
+    auto player = world.getPlayer(0);
+    position playerPosition = player->getPosition();
+    cout << "world setup   : " << chrono::duration<double, milli>(loadEnd - loadStart).count() << " ms" << endl;
+    cout << "turns         : " << turns << endl;
+    cout << "turns/sec     : " << (seconds > 0 ? turns / seconds : 0.0) << endl;
+    cout << "p50 latency   : " << percentile(0.50) << " us" << endl;
+    cout << "p99 latency   : " << percentile(0.99) << " us" << endl;
+    cout << "enemies left  : " << world.getEnemyCount() << endl;
+    cout << "player health : " << player->getHealth() << endl;
+    cout << "player at     : " << playerPosition.first << ", " << playerPosition.second << endl;
+    cout << "state hash    : " << hex << world.stateHash() << dec << endl;
+    if(options.history > 0)
+    {
+        size_t kept = world.getUndoDepth() + 1;
+        size_t bytes = world.getHistoryBytes();
+        cout << "undo history  : " << kept << " turns, " << bytes / 1024 << " KB ("
+             << bytes / kept << " bytes/turn, " << world.getHistoryWritten() << " written last turn)" << endl;
+    }
+    PROFILE_SUMMARY(cout);
+    world.setEventLog(nullptr);
+    if(!closeEventLog(events.get()))
+        return false;
+
+    if(allocationTracking)
+    {
+        long measured = max(0L, turns - options.warmup);
+        cout << "allocs/turn   : " << (measured ? double(allocationsAfterWarmup) / measured : 0.0)
+             << " (max " << maxTurnAllocations << ", after " << options.warmup << " warm up turns)" << endl;
+
+        if(options.assertNoAlloc && allocationsAfterWarmup > 0)
+        {
+            cerr << allocationsAfterWarmup << " heap allocations after warm up" << endl;
+            return false;
+        }
+    }
+
+    if(!options.savePath.empty())
+        return checkSaveRoundTrip(world, options.savePath);
+    return true;
+}
+
+bool runReplay(const string& path, ThreadPool& pool)
+{
+    JournalReader journal;
+    JournalSetup setup;
+    if(!journal.open(path, setup))
+    {
+        cerr << "Could not read journal " << path << endl;
+        return false;
+    }
+
+    auto worldPointer = createWorld(setup.levelPath, setup.worldLimits, setup.seed,
+            setup.enemies, setup.hounds, setup.swoopers, setup.guards);
+    if(!worldPointer)
+        return false;
+    World& world = *worldPointer;
+    world.setThreadPool(&pool);
+    world.setHistoryDepth(setup.history);
+    Parser parser{};
+
+    vector<double> latencies;
+    string_view command;
+    uint64_t expected = 0;
+    long turns = 0;
+    bool matched = true;
+
+    auto start = chrono::steady_clock::now();
+    while(journal.next(command, expected))
+    {
+        auto turnStart = chrono::steady_clock::now();
+
+        auto player = world.getPlayer(0);
+        world.resetWorldMap();
+        player->checkCollisions(world);
+        world.EnemiesTurn();
+        bool keepGoing = parser.parseCommand(command, world);
+
+        auto turnEnd = chrono::steady_clock::now();
+        latencies.push_back(chrono::duration<double, micro>(turnEnd - turnStart).count());
+        PROFILE_END_TURN();
+        turns++;
+
+        uint64_t actual = world.stateHash();
+        if(actual != expected)
+        {
+            cerr << "Turn " << turns << " (\"" << command << "\") diverged, state hash "
+                 << hex << actual << " instead of " << expected << dec << endl;
+            matched = false;
+            break;
+        }
+
+        if(!keepGoing)
+            break;
+    }
+    auto end = chrono::steady_clock::now();
+
+    if(matched && !journal.atEnd())
+    {
+        cerr << "Journal " << path << " is truncated or has turns after quit" << endl;
+        matched = false;
+    }
+
+    double seconds = chrono::duration<double>(end - start).count();
+    double simulated = accumulate(latencies.begin(), latencies.end(), 0.0) / 1e6;
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies.empty() ? 0.0 : latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+    };
+
+    cout << "seed          : " << setup.seed << endl;
+    cout << "turns         : " << turns << endl;
+    cout << "turns/sec     : " << (simulated > 0 ? turns / simulated : 0.0)
+         << " (" << (seconds > 0 ? turns / seconds : 0.0) << " with verification)" << endl;
+    cout << "p50 latency   : " << percentile(0.50) << " us" << endl;
+    cout << "p99 latency   : " << percentile(0.99) << " us" << endl;
+    cout << "verified      : " << (matched ? "yes" : "no") << endl;
+    return matched;
+}
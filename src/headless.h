@@ -0,0 +1,56 @@
+#pragma once
+
+#include "thread_pool.h"
+#include "world.h"
+
+struct HeadlessOptions
+{
+    long turns = 10000;
+    unsigned seed = 1;
+    int enemies = 0;
+    int hounds = 0;
+    // Bats and hounds running the swoopingBat and guardingHound scripts.
+    int swoopers = 0;
+    int guards = 0;
+    string batchPath;
+    string levelPath;
+    limits worldLimits = World::defaultWorldLimits();
+
+    // Turns after which the loop is expected to stop allocating.
+    long warmup = 100;
+    bool assertNoAlloc = false;
+
+    // Saves the final state here and checks it loads back the same.
+    string savePath;
+
+    string recordPath;
+
+    // Combat events, as text lines or binary records.
+    string eventsPath;
+    bool eventsBinary = false;
+
+    // Players only see what their field of view reaches.
+    bool fog = false;
+
+    // Turns kept for undo, none unless --history asks. Keeping one
+    // writes the whole world, that costs with its size every turn.
+    size_t history = 0;
+};
+
+// Null when no log was asked for, or it couldn't be created.
+unique_ptr<EventLog> openEventLog(const HeadlessOptions& options, bool& ok);
+// Waits for the writer to catch up, then reports.
+bool closeEventLog(EventLog* log);
+// Reads a whole command script in one go, "-" means stdin.
+bool loadCommandScript(const string& path, string& script);
+
+// Saves the world, loads the file into a fresh one and checks the
+// two hash the same.
+bool checkSaveRoundTrip(const World& world, const string& path);
+// Runs the turn pipeline without rendering and reports throughput
+// and latency. Commands come from the player bot, or from a script
+// (one command per line) when a batch path is given.
+bool runHeadless(const HeadlessOptions& options, ThreadPool& pool);
+// Plays a journal back as fast as it goes, nothing is drawn.
+// Stops at the first turn whose state doesn't match the recording.
+bool runReplay(const string& path, ThreadPool& pool);
@@ -0,0 +1,161 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "world.h"
+
+// Session journal, enough to play a session back exactly:
+//   header   : JournalHeader, then the level path (may be empty)
+//   turns    : varint command length, command bytes, uint64 state hash
+// The hash is World::stateHash() right after the command ran.
+struct JournalHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t seed;
+    int32_t height;
+    int32_t width;
+    int32_t enemies;
+    int32_t hounds;
+    int32_t swoopers;
+    int32_t guards;
+    uint32_t history;
+    uint32_t levelPathLength;
+};
+
+constexpr char JOURNAL_MAGIC[8] = { 'T', 'T', 'R', 'P', 'G', 'J', 'N', 'L' };
+constexpr uint32_t JOURNAL_VERSION = 7;
+
+// What createWorld needs to rebuild the starting world.
+struct JournalSetup
+{
+    unsigned seed = 0;
+    limits worldLimits {0, 0};
+    int enemies = 0;
+    int hounds = 0;
+    string levelPath;
+    int swoopers = 0;
+    int guards = 0;
+    // Undo in the journal only plays back the same with as many turns kept.
+    size_t history = 0;
+};
+
+class JournalWriter
+{
+
+private:
+
+    ofstream out_;
+
+public:
+
+    bool open(const string& path, const JournalSetup& setup)
+    {
+        out_.open(path, ios::binary | ios::trunc);
+        if(!out_)
+            return false;
+
+        JournalHeader header{};
+        memcpy(header.magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+        header.version         = JOURNAL_VERSION;
+        header.seed            = setup.seed;
+        header.height          = setup.worldLimits.first;
+        header.width           = setup.worldLimits.second;
+        header.enemies         = setup.enemies;
+        header.hounds          = setup.hounds;
+        header.swoopers        = setup.swoopers;
+        header.guards          = setup.guards;
+        header.history         = static_cast<uint32_t>(setup.history);
+        header.levelPathLength = static_cast<uint32_t>(setup.levelPath.size());
+
+        out_.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out_.write(setup.levelPath.data(), setup.levelPath.size());
+        return static_cast<bool>(out_);
+    }
+
+    bool isOpen() const { return out_.is_open(); }
+
+    void record(string_view command, uint64_t stateHash)
+    {
+        // Commands are short, the length is a varint so most of
+        // them cost one byte.
+        size_t length = command.size();
+        do
+        {
+            char byte = static_cast<char>(length & 0x7f);
+            length >>= 7;
+            if(length)
+                byte |= 0x80;
+            out_.put(byte);
+        } while(length);
+
+        out_.write(command.data(), command.size());
+        out_.write(reinterpret_cast<const char*>(&stateHash), sizeof(stateHash));
+    }
+};
+
+class JournalReader
+{
+
+private:
+
+    vector<char> data_;
+    size_t offset_ = 0;
+
+public:
+
+    bool open(const string& path, JournalSetup& setup)
+    {
+        ifstream in(path, ios::binary);
+        if(!in)
+            return false;
+        data_.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+
+        JournalHeader header;
+        if(data_.size() < sizeof(header))
+            return false;
+        memcpy(&header, data_.data(), sizeof(header));
+        if(memcmp(header.magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0
+                || header.version != JOURNAL_VERSION
+                || header.levelPathLength > data_.size() - sizeof(header))
+            return false;
+
+        setup.seed        = header.seed;
+        setup.worldLimits = limits(header.height, header.width);
+        setup.enemies     = header.enemies;
+        setup.hounds      = header.hounds;
+        setup.swoopers    = header.swoopers;
+        setup.guards      = header.guards;
+        setup.history     = header.history;
+        setup.levelPath.assign(data_.data() + sizeof(header), header.levelPathLength);
+
+        offset_ = sizeof(header) + header.levelPathLength;
+        return true;
+    }
+
+    bool atEnd() const { return offset_ == data_.size(); }
+
+    // False at the end, or when the last turn was cut short.
+    bool next(string_view& command, uint64_t& stateHash)
+    {
+        size_t length = 0;
+        for(int shift = 0; ; shift += 7)
+        {
+            if(offset_ == data_.size() || shift > 28)
+                return false;
+            unsigned char byte = data_[offset_++];
+            length |= static_cast<size_t>(byte & 0x7f) << shift;
+            if(!(byte & 0x80))
+                break;
+        }
+
+        if(length + sizeof(stateHash) > data_.size() - offset_)
+            return false;
+
+        command = string_view(data_.data() + offset_, length);
+        memcpy(&stateHash, data_.data() + offset_ + length, sizeof(stateHash));
+        offset_ += length + sizeof(stateHash);
+        return true;
+    }
+};
@@ -0,0 +1,177 @@
+#include "level.h"
+#include "world.h"
+
+bool convertAsciiMap(const string& inputPath, const string& outputPath)
+{
+    ifstream input(inputPath);
+    if(!input)
+    {
+        cerr << "Could not read " << inputPath << endl;
+        return false;
+    }
+
+    vector<string> rows;
+    string line;
+    size_t width = 0;
+    while(getline(input, line))
+    {
+        if(!line.empty() && line.back() == '\r')
+            line.pop_back();
+        width = max(width, line.size());
+        rows.push_back(move(line));
+    }
+
+    size_t maxSide = static_cast<size_t>(World::WORLD_CONSTANTS::MAX_WORLD_SIDE);
+    if(rows.empty() || width == 0 || rows.size() > maxSide || width > maxSide)
+    {
+        cerr << inputPath << " must be a non empty map up to " << maxSide << " on a side" << endl;
+        return false;
+    }
+
+    const char ground = '.';
+    const int chunkSize = ChunkedMap::CHUNK_SIZE;
+
+    LevelHeader header{};
+    memcpy(header.magic, LEVEL_MAGIC, sizeof(LEVEL_MAGIC));
+    header.version      = LEVEL_VERSION;
+    header.chunkSize    = chunkSize;
+    header.height       = static_cast<int32_t>(rows.size());
+    header.width        = static_cast<int32_t>(width);
+    header.chunkRows    = (header.height + ChunkedMap::CHUNK_MASK) >> ChunkedMap::CHUNK_SHIFT;
+    header.chunkColumns = (header.width + ChunkedMap::CHUNK_MASK) >> ChunkedMap::CHUNK_SHIFT;
+    header.ground       = ground;
+
+    vector<LevelCollider> colliders;
+    vector<LevelSpawn> spawns;
+    string names;
+
+    auto addSpawn = [&](Entity::ENTYPE type, ENEMY_TYPE enemyType, char sprite, int row,
+            int column, int health, int attack, int defense, const string& name) {
+        LevelSpawn spawn{};
+        spawn.entityType = static_cast<uint8_t>(type);
+        spawn.enemyType  = static_cast<uint8_t>(enemyType);
+        spawn.sprite     = sprite;
+        spawn.row        = row;
+        spawn.column     = column;
+        spawn.health     = health;
+        spawn.attack     = attack;
+        spawn.defense    = defense;
+        spawn.nameOffset = static_cast<uint32_t>(names.size());
+        spawn.nameLength = static_cast<uint32_t>(name.size());
+        names += name;
+        spawns.push_back(spawn);
+    };
+
+    // Terrain is kept chunk by chunk, chunks that are all ground aren't stored.
+    size_t chunkCount = static_cast<size_t>(header.chunkRows) * header.chunkColumns;
+    vector<string> chunks(chunkCount);
+    int bats = 0;
+    int hounds = 0;
+
+    for(int row = 0; row < header.height; row++)
+    {
+        const string& text = rows[row];
+        for(int column = 0; column < static_cast<int>(text.size()); column++)
+        {
+            char sprite = text[column];
+            if(sprite == ground || sprite == ' ')
+                continue;
+
+            if(sprite == 'J' || sprite == '@')
+            {
+                addSpawn(Entity::ENTYPE::PLAYER, ENEMY_TYPE::BLIND_BAT, 'J', row, column,
+                        200, 20, 30, "John");
+                continue;
+            }
+            if(sprite == 'B')
+            {
+                addSpawn(Entity::ENTYPE::ENEMY, ENEMY_TYPE::BLIND_BAT, 'B', row, column,
+                        BlindBatArchetype::health, BlindBatArchetype::attack,
+                        BlindBatArchetype::defense, string(BlindBatArchetype::name) + " " + to_string(++bats));
+                continue;
+            }
+            if(sprite == 'H')
+            {
+                addSpawn(Entity::ENTYPE::ENEMY, ENEMY_TYPE::HOUND, 'H', row, column,
+                        HoundArchetype::health, HoundArchetype::attack,
+                        HoundArchetype::defense, string(HoundArchetype::name) + " " + to_string(++hounds));
+                continue;
+            }
+
+            string& chunk = chunks[(row / chunkSize) * header.chunkColumns + column / chunkSize];
+            if(chunk.empty())
+                chunk.assign(ChunkedMap::CHUNK_CELLS, ground);
+            chunk[(row % chunkSize) * chunkSize + column % chunkSize] = sprite;
+
+            LevelCollider collider{};
+            collider.row    = row;
+            collider.column = column;
+            collider.sprite = sprite;
+            colliders.push_back(collider);
+        }
+    }
+
+    auto align = [](uint64_t offset, uint64_t alignment) {
+        return (offset + alignment - 1) / alignment * alignment;
+    };
+
+    header.chunkTableOffset = sizeof(LevelHeader);
+    header.colliderOffset   = align(header.chunkTableOffset + chunkCount * sizeof(uint64_t), 8);
+    header.colliderCount    = colliders.size();
+    header.spawnOffset      = align(header.colliderOffset + colliders.size() * sizeof(LevelCollider), 8);
+    header.spawnCount       = spawns.size();
+    header.namesOffset      = header.spawnOffset + spawns.size() * sizeof(LevelSpawn);
+    header.namesSize        = names.size();
+
+    vector<uint64_t> chunkOffsets(chunkCount, 0);
+    uint64_t offset = align(header.namesOffset + names.size(), LEVEL_PAGE);
+    for(size_t i = 0; i < chunkCount; i++)
+    {
+        if(chunks[i].empty())
+            continue;
+        chunkOffsets[i] = offset;
+        offset += ChunkedMap::CHUNK_CELLS;
+    }
+
+    ofstream output(outputPath, ios::binary | ios::trunc);
+    if(!output)
+    {
+        cerr << "Could not write " << outputPath << endl;
+        return false;
+    }
+
+    auto writeAt = [&](uint64_t at, const void* data, size_t size) {
+        output.seekp(at);
+        output.write(static_cast<const char*>(data), size);
+    };
+
+    writeAt(0, &header, sizeof(header));
+    writeAt(header.chunkTableOffset, chunkOffsets.data(), chunkOffsets.size() * sizeof(uint64_t));
+    writeAt(header.colliderOffset, colliders.data(), colliders.size() * sizeof(LevelCollider));
+    writeAt(header.spawnOffset, spawns.data(), spawns.size() * sizeof(LevelSpawn));
+    writeAt(header.namesOffset, names.data(), names.size());
+    for(size_t i = 0; i < chunkCount; i++)
+    {
+        if(chunkOffsets[i])
+            writeAt(chunkOffsets[i], chunks[i].data(), chunks[i].size());
+    }
+
+    // Pad the tail so the last page is fully inside the file.
+    output.seekp(0, ios::end);
+    uint64_t end = output.tellp();
+    if(end < offset)
+    {
+        string padding(offset - end, '\0');
+        output.write(padding.data(), padding.size());
+    }
+
+    if(!output)
+    {
+        cerr << "Failed writing " << outputPath << endl;
+        return false;
+    }
+
+    cout << "Wrote " << outputPath << " : " << header.height << "x" << header.width << ", "
+         << colliders.size() << " colliders, " << spawns.size() << " spawns" << endl;
+    return true;
+}
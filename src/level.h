@@ -0,0 +1,217 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "chunked_map.h"
+#include "entity.h"
+
+// Binary level layout, integers in host (little endian) order.
+// Terrain chunks are page aligned so they can be used straight
+// from the mapping and shared between processes.
+//
+//   LevelHeader
+//   chunk table   : uint64 offset per chunk, 0 for plain ground
+//   colliders     : LevelCollider[colliderCount]
+//   spawns        : LevelSpawn[spawnCount]
+//   names         : spawn names, not null terminated
+//   chunk data    : CHUNK_CELLS bytes per stored chunk
+struct LevelHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t chunkSize;
+    int32_t height;
+    int32_t width;
+    uint32_t chunkRows;
+    uint32_t chunkColumns;
+    uint64_t chunkTableOffset;
+    uint64_t colliderOffset;
+    uint64_t colliderCount;
+    uint64_t spawnOffset;
+    uint64_t spawnCount;
+    uint64_t namesOffset;
+    uint64_t namesSize;
+    char ground;
+    char reserved[7];
+};
+
+struct LevelCollider
+{
+    int32_t row;
+    int32_t column;
+    char sprite;
+    char reserved[3];
+};
+
+struct LevelSpawn
+{
+    uint8_t entityType;
+    uint8_t enemyType;
+    char sprite;
+    uint8_t reserved;
+    int32_t row;
+    int32_t column;
+    int32_t health;
+    int32_t attack;
+    int32_t defense;
+    uint32_t nameOffset;
+    uint32_t nameLength;
+};
+
+static_assert(sizeof(LevelHeader) == 96, "level header layout changed");
+static_assert(sizeof(LevelCollider) == 12, "level collider layout changed");
+static_assert(sizeof(LevelSpawn) == 32, "level spawn layout changed");
+
+constexpr char LEVEL_MAGIC[8] = { 'T', 'T', 'R', 'P', 'G', 'L', 'V', 'L' };
+constexpr uint32_t LEVEL_VERSION = 1;
+constexpr size_t LEVEL_PAGE = 4096;
+
+// A read only mapping of a level file. Worlds built from it keep
+// it alive and read the terrain chunks in place.
+class LevelFile
+{
+
+private:
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    string path_;
+
+    LevelFile() = default;
+
+    bool fits(uint64_t offset, uint64_t count, size_t itemSize) const
+    {
+        return offset <= size_ && count <= (size_ - offset) / itemSize;
+    }
+
+    bool validate() const
+    {
+        if(size_ < sizeof(LevelHeader))
+            return false;
+
+        auto& header = getHeader();
+        int maxSide = 1 << 17;
+        if(memcmp(header.magic, LEVEL_MAGIC, sizeof(LEVEL_MAGIC)) != 0
+                || header.version != LEVEL_VERSION
+                || header.chunkSize != ChunkedMap::CHUNK_SIZE
+                || header.height <= 0 || header.width <= 0
+                || header.height > maxSide || header.width > maxSide
+                || header.chunkRows != static_cast<uint32_t>((header.height + ChunkedMap::CHUNK_MASK) >> ChunkedMap::CHUNK_SHIFT)
+                || header.chunkColumns != static_cast<uint32_t>((header.width + ChunkedMap::CHUNK_MASK) >> ChunkedMap::CHUNK_SHIFT))
+            return false;
+
+        uint64_t chunkCount = static_cast<uint64_t>(header.chunkRows) * header.chunkColumns;
+        if(!fits(header.chunkTableOffset, chunkCount, sizeof(uint64_t))
+                || !fits(header.colliderOffset, header.colliderCount, sizeof(LevelCollider))
+                || !fits(header.spawnOffset, header.spawnCount, sizeof(LevelSpawn))
+                || !fits(header.namesOffset, header.namesSize, 1))
+            return false;
+
+        for(uint64_t i = 0; i < chunkCount; i++)
+        {
+            uint64_t offset = getChunkOffsets()[i];
+            if(offset && !fits(offset, 1, ChunkedMap::CHUNK_CELLS))
+                return false;
+        }
+
+        for(uint64_t i = 0; i < header.spawnCount; i++)
+        {
+            auto& spawn = getSpawns()[i];
+            if(static_cast<uint64_t>(spawn.nameOffset) + spawn.nameLength > header.namesSize)
+                return false;
+        }
+        return true;
+    }
+
+public:
+
+    LevelFile(const LevelFile&) = delete;
+    LevelFile& operator=(const LevelFile&) = delete;
+
+    ~LevelFile()
+    {
+        if(data_)
+            munmap(const_cast<char*>(data_), size_);
+    }
+
+    // Returns nullptr, after saying why on cerr,
+    // when the file can't be mapped or is malformed.
+    static shared_ptr<const LevelFile> open(const string& path)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0)
+        {
+            cerr << "Could not open level " << path << " : " << strerror(errno) << endl;
+            return nullptr;
+        }
+
+        struct stat info;
+        if(fstat(fd, &info) != 0 || info.st_size <= 0)
+        {
+            cerr << "Could not read level " << path << endl;
+            ::close(fd);
+            return nullptr;
+        }
+
+        void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if(mapping == MAP_FAILED)
+        {
+            cerr << "Could not map level " << path << " : " << strerror(errno) << endl;
+            return nullptr;
+        }
+
+        shared_ptr<LevelFile> level(new LevelFile());
+        level->data_ = static_cast<const char*>(mapping);
+        level->size_ = info.st_size;
+        level->path_ = path;
+
+        if(!level->validate())
+        {
+            cerr << path << " is not a valid version " << LEVEL_VERSION << " level" << endl;
+            return nullptr;
+        }
+        return level;
+    }
+
+    const char* getData() const { return data_; }
+    const string& getPath() const { return path_; }
+
+    const LevelHeader& getHeader() const
+    {
+        return *reinterpret_cast<const LevelHeader*>(data_);
+    }
+
+    limits getLimits() const
+    {
+        return limits(getHeader().height, getHeader().width);
+    }
+
+    const uint64_t* getChunkOffsets() const
+    {
+        return reinterpret_cast<const uint64_t*>(data_ + getHeader().chunkTableOffset);
+    }
+
+    const LevelCollider* getColliders() const
+    {
+        return reinterpret_cast<const LevelCollider*>(data_ + getHeader().colliderOffset);
+    }
+
+    const LevelSpawn* getSpawns() const
+    {
+        return reinterpret_cast<const LevelSpawn*>(data_ + getHeader().spawnOffset);
+    }
+
+    string_view getName(const LevelSpawn& spawn) const
+    {
+        return string_view(data_ + getHeader().namesOffset + spawn.nameOffset, spawn.nameLength);
+    }
+};
+
+// Turns a plain text map into a binary level. '.' and ' ' are ground,
+// 'J' or '@' is the player, 'B' a blind bat, 'H' a hound and anything
+// else is a wall like sprite that also collides.
+bool convertAsciiMap(const string& inputPath, const string& outputPath);
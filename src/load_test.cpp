@@ -0,0 +1,191 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include "load_test.h"
+#include "server.h"
+
+bool runLoadTest(const LoadTestOptions& options)
+{
+    struct Connection
+    {
+        int fd = -1;
+        string input;
+        long turnsLeft = 0;
+        long commandsSent = 0;
+        chrono::steady_clock::time_point sentAt;
+    };
+
+    static constexpr string_view commands[] = {
+        "up\n", "down\n", "left\n", "right\n",
+        "attack up\n", "attack down\n", "attack left\n", "attack right\n",
+    };
+
+    SocketAddress address;
+    if(!parseSocketAddress(options.address, address))
+    {
+        cerr << "Bad address " << options.address << ", expected unix:PATH or tcp:PORT" << endl;
+        return false;
+    }
+
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if(epollFd < 0)
+    {
+        cerr << "Could not create epoll : " << strerror(errno) << endl;
+        return false;
+    }
+
+    vector<Connection> connections(options.clients);
+    auto connectStart = chrono::steady_clock::now();
+    for(size_t i = 0; i < connections.size(); i++)
+    {
+        int fd = socket(address.storage.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if(fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&address.storage), address.length) < 0)
+        {
+            cerr << "Could not connect to " << options.address << " : " << strerror(errno) << endl;
+            if(fd >= 0)
+                close(fd);
+            connections.resize(i);
+            break;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        setNoDelay(fd, address);
+
+        connections[i].fd = fd;
+        connections[i].turnsLeft = options.turns;
+
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = i;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    }
+    auto connectEnd = chrono::steady_clock::now();
+
+    if(connections.empty())
+    {
+        close(epollFd);
+        return false;
+    }
+
+    mt19937 gen(options.seed);
+    vector<double> latencies;
+    latencies.reserve(connections.size() * options.turns);
+    size_t bytesReceived = 0;
+    size_t active = connections.size();
+    bool failed = false;
+
+    auto finish = [&](Connection& connection) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, connection.fd, nullptr);
+        close(connection.fd);
+        connection.fd = -1;
+        active--;
+    };
+
+    // Frames that don't show our last command yet are just world updates.
+    auto onFrame = [&](Connection& connection, string_view frame) {
+        size_t at = frame.rfind(FRAME_COMMANDS);
+        long shown = at == string_view::npos ? -1
+            : strtol(frame.data() + at + FRAME_COMMANDS.size(), nullptr, 10);
+        if(shown != connection.commandsSent)
+            return;
+
+        auto now = chrono::steady_clock::now();
+        if(connection.commandsSent > 0)
+        {
+            latencies.push_back(chrono::duration<double, micro>(now - connection.sentAt).count());
+            connection.turnsLeft--;
+        }
+        if(connection.turnsLeft == 0)
+        {
+            finish(connection);
+            return;
+        }
+
+        string_view command = commands[gen() % size(commands)];
+        connection.sentAt = now;
+        connection.commandsSent++;
+        if(send(connection.fd, command.data(), command.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(command.size()))
+        {
+            failed = true;
+            finish(connection);
+        }
+    };
+
+    constexpr int MAX_EVENTS = 256;
+    epoll_event events[MAX_EVENTS];
+    char buffer[1 << 16];
+
+    auto start = chrono::steady_clock::now();
+    while(active > 0)
+    {
+        int ready = epoll_wait(epollFd, events, MAX_EVENTS, 5000);
+        if(ready == 0)
+        {
+            cerr << "No frame for 5 seconds, " << active << " connections still waiting" << endl;
+            failed = true;
+            break;
+        }
+        if(ready < 0)
+        {
+            if(errno == EINTR)
+                continue;
+            cerr << "epoll_wait failed : " << strerror(errno) << endl;
+            failed = true;
+            break;
+        }
+
+        for(int i = 0; i < ready; i++)
+        {
+            Connection& connection = connections[events[i].data.u64];
+            if(connection.fd < 0)
+                continue;
+
+            ssize_t count;
+            while((count = read(connection.fd, buffer, sizeof(buffer))) > 0)
+            {
+                bytesReceived += count;
+                connection.input.append(buffer, count);
+            }
+            if(count == 0 || (count < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
+            {
+                cerr << "Server closed a connection" << endl;
+                failed = true;
+                finish(connection);
+                continue;
+            }
+
+            size_t frameEnd;
+            while(connection.fd >= 0 && (frameEnd = connection.input.find(FRAME_END)) != string::npos)
+            {
+                onFrame(connection, string_view(connection.input.data(), frameEnd));
+                connection.input.erase(0, frameEnd + 1);
+            }
+        }
+    }
+    auto end = chrono::steady_clock::now();
+
+    for(auto& connection : connections)
+    {
+        if(connection.fd >= 0)
+            close(connection.fd);
+    }
+    close(epollFd);
+
+    double seconds = chrono::duration<double>(end - start).count();
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies.empty() ? 0.0 : latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+    };
+
+    cout << "connections   : " << connections.size() << endl;
+    cout << "connect time  : " << chrono::duration<double, milli>(connectEnd - connectStart).count() << " ms" << endl;
+    cout << "turns         : " << latencies.size() << endl;
+    cout << "turns/sec     : " << (seconds > 0 ? latencies.size() / seconds : 0.0) << endl;
+    cout << "p50 latency   : " << percentile(0.50) << " us" << endl;
+    cout << "p99 latency   : " << percentile(0.99) << " us" << endl;
+    cout << "max latency   : " << (latencies.empty() ? 0.0 : latencies.back()) << " us" << endl;
+    cout << "bytes/turn    : " << (latencies.empty() ? 0 : bytesReceived / latencies.size()) << endl;
+    return !failed;
+}
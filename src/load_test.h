@@ -0,0 +1,16 @@
+#pragma once
+
+#include "common.h"
+
+struct LoadTestOptions
+{
+    string address;
+    int clients = 100;
+    long turns = 100;   // per connection
+    unsigned seed = 1;
+};
+
+// Opens many connections to a server and plays each one with random
+// commands, a turn is timed from sending a command to the frame that
+// shows it.
+bool runLoadTest(const LoadTestOptions& options);
@@ -0,0 +1,361 @@
+#include "bench.h"
+#include "headless.h"
+#include "journal.h"
+#include "load_test.h"
+#include "parser.h"
+#include "realtime.h"
+#include "rooms.h"
+#include "server.h"
+#include "setup.h"
+
+// Reads sizes written as HEIGHTxWIDTH, like 10x60.
+bool parseLimits(const char* text, limits& result)
+{
+    int height = 0, width = 0;
+    if(sscanf(text, "%dx%d", &height, &width) != 2)
+        return false;
+
+    int maxSide = static_cast<int>(World::WORLD_CONSTANTS::MAX_WORLD_SIDE);
+    if(height <= 0 || width <= 0 || height > maxSide || width > maxSide)
+        return false;
+
+    result = limits(height, width);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    Renderer renderer{};
+    HeadlessOptions headless{};
+    ServerOptions server{};
+    LoadTestOptions loadTest{};
+    RoomOptions rooms{};
+    RealtimeOptions realtime{};
+    BenchSuiteOptions benchSuite{};
+#if defined(TURN_PROFILER)
+    string tracePath;
+#endif
+    bool runHeadlessMode = false;
+    bool runBenchmark = false;
+    string replayPath;
+    size_t threads = max(1u, thread::hardware_concurrency());
+    limits viewport = World::defaultWorldLimits();
+
+    for(int i = 1; i < argc; i++)
+    {
+        bool hasValue = i + 1 < argc;
+
+        if(strcmp(argv[i], "--bench") == 0)
+        {
+            runBenchmark = true;
+        }
+        else if(strcmp(argv[i], "--bench-suite") == 0 && hasValue)
+        {
+            benchSuite.outputPath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--bench-baseline") == 0 && hasValue)
+        {
+            benchSuite.baselinePath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--bench-tolerance") == 0 && hasValue)
+        {
+            benchSuite.tolerance = atof(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--bench-filter") == 0 && hasValue)
+        {
+            benchSuite.filter = argv[++i];
+        }
+        else if(strcmp(argv[i], "--threads") == 0 && hasValue)
+        {
+            threads = max(1L, atol(argv[++i]));
+        }
+        else if(strcmp(argv[i], "--full-redraw") == 0)
+        {
+            renderer.setFullRedraw(true);
+        }
+        else if(strcmp(argv[i], "--headless") == 0)
+        {
+            runHeadlessMode = true;
+        }
+        else if(strcmp(argv[i], "--turns") == 0 && hasValue)
+        {
+            headless.turns = atol(argv[++i]);
+            loadTest.turns = headless.turns;
+        }
+        else if(strcmp(argv[i], "--serve") == 0 && hasValue)
+        {
+            server.address = argv[++i];
+        }
+        else if(strcmp(argv[i], "--rounds") == 0 && hasValue)
+        {
+            server.rounds = atol(argv[++i]);
+            rooms.rounds = server.rounds;
+        }
+        else if(strcmp(argv[i], "--rooms") == 0 && hasValue)
+        {
+            rooms.rooms = strtoul(argv[++i], nullptr, 10);
+        }
+        else if(strcmp(argv[i], "--room-turns") == 0 && hasValue)
+        {
+            rooms.roomTurns = max(1L, atol(argv[++i]));
+        }
+        else if(strcmp(argv[i], "--room-stats") == 0 && hasValue)
+        {
+            rooms.statsPath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--tick") == 0 && hasValue)
+        {
+            server.tickMs = max(1, atoi(argv[++i]));
+        }
+        else if(strcmp(argv[i], "--load-test") == 0 && hasValue)
+        {
+            loadTest.address = argv[++i];
+        }
+        else if(strcmp(argv[i], "--clients") == 0 && hasValue)
+        {
+            loadTest.clients = max(1, atoi(argv[++i]));
+        }
+        else if(strcmp(argv[i], "--seed") == 0 && hasValue)
+        {
+            headless.seed = static_cast<unsigned>(strtoul(argv[++i], nullptr, 10));
+            server.seed = loadTest.seed = headless.seed;
+        }
+        else if(strcmp(argv[i], "--enemies") == 0 && hasValue)
+        {
+            headless.enemies = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--hounds") == 0 && hasValue)
+        {
+            headless.hounds = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--fog") == 0)
+        {
+            headless.fog = true;
+        }
+        else if(strcmp(argv[i], "--swoopers") == 0 && hasValue)
+        {
+            headless.swoopers = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--guards") == 0 && hasValue)
+        {
+            headless.guards = atoi(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--history") == 0 && hasValue)
+        {
+            headless.history = static_cast<size_t>(max(0L, atol(argv[++i])));
+        }
+        else if(strcmp(argv[i], "--world") == 0 && hasValue)
+        {
+            if(!parseLimits(argv[++i], headless.worldLimits))
+            {
+                cerr << "Bad world size " << argv[i] << ", expected HEIGHTxWIDTH up to "
+                     << static_cast<int>(World::WORLD_CONSTANTS::MAX_WORLD_SIDE) << endl;
+                return EXIT_FAILURE;
+            }
+        }
+        else if(strcmp(argv[i], "--viewport") == 0 && hasValue)
+        {
+            if(!parseLimits(argv[++i], viewport))
+            {
+                cerr << "Bad viewport size " << argv[i] << ", expected HEIGHTxWIDTH" << endl;
+                return EXIT_FAILURE;
+            }
+        }
+        else if(strcmp(argv[i], "--level") == 0 && hasValue)
+        {
+            headless.levelPath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--convert-map") == 0 && i + 2 < argc)
+        {
+            bool converted = convertAsciiMap(argv[i + 1], argv[i + 2]);
+            return converted ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        else if(strcmp(argv[i], "--count-allocs") == 0)
+        {
+            allocationTracking = true;
+        }
+        else if(strcmp(argv[i], "--assert-no-alloc") == 0)
+        {
+            allocationTracking = true;
+            headless.assertNoAlloc = true;
+        }
+        else if(strcmp(argv[i], "--warmup") == 0 && hasValue)
+        {
+            headless.warmup = atol(argv[++i]);
+        }
+        else if(strcmp(argv[i], "--record") == 0 && hasValue)
+        {
+            headless.recordPath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--replay") == 0 && hasValue)
+        {
+            replayPath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--save-check") == 0 && hasValue)
+        {
+            runHeadlessMode = true;
+            headless.savePath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--trace") == 0 && hasValue)
+        {
+#if defined(TURN_PROFILER)
+            tracePath = argv[++i];
+#else
+            cerr << "--trace needs a build with -DTURN_PROFILER" << endl;
+            return EXIT_FAILURE;
+#endif
+        }
+        else if(strcmp(argv[i], "--realtime") == 0)
+        {
+            realtime.enabled = true;
+        }
+        else if(strcmp(argv[i], "--tick-rate") == 0 && hasValue)
+        {
+            realtime.tickRate = max(1, atoi(argv[++i]));
+        }
+        else if(strcmp(argv[i], "--fps") == 0 && hasValue)
+        {
+            realtime.frameRate = max(1, atoi(argv[++i]));
+        }
+        else if(strcmp(argv[i], "--ticks") == 0 && hasValue)
+        {
+            realtime.ticks = max(0L, atol(argv[++i]));
+        }
+        else if(strcmp(argv[i], "--events") == 0 && hasValue)
+        {
+            headless.eventsPath = argv[++i];
+        }
+        else if(strcmp(argv[i], "--events-binary") == 0 && hasValue)
+        {
+            headless.eventsPath = argv[++i];
+            headless.eventsBinary = true;
+        }
+        else if(strcmp(argv[i], "--batch") == 0 && hasValue)
+        {
+            runHeadlessMode = true;
+            headless.batchPath = argv[++i];
+        }
+        else
+        {
+            cerr << "Unknown option " << argv[i] << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+#if defined(TURN_PROFILER)
+    ProfileTrace trace(tracePath);
+#endif
+
+    // Rooms bring their own pool, a room's turn isn't split up.
+    if(rooms.rooms > 0)
+        return runRooms(headless, rooms, threads) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    // Enemy decisions are spread over these, results don't
+    // depend on how many there are.
+    ThreadPool pool{threads};
+
+    if(runBenchmark)
+    {
+        runTurnBenchmark(pool);
+        runBehaviourBenchmark();
+        return EXIT_SUCCESS;
+    }
+
+    if(!benchSuite.outputPath.empty())
+    {
+        cerr << "threads : " << pool.getThreadCount() << endl;
+        BenchSuite suite{benchSuite};
+        runBenchSuite(suite, pool);
+        bool written = suite.write();
+        return written && suite.compare() && !suite.hasFailures() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if(!loadTest.address.empty())
+        return runLoadTest(loadTest) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if(!server.address.empty())
+        return runServer(headless, server, viewport, pool) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if(!replayPath.empty())
+        return runReplay(replayPath, pool) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if(runHeadlessMode)
+        return runHeadless(headless, pool) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    unsigned seed = random_device{}();
+    auto worldPointer = createWorld(headless.levelPath, headless.worldLimits,
+            seed, headless.enemies, headless.hounds, headless.swoopers, headless.guards);
+    if(!worldPointer)
+        return EXIT_FAILURE;
+
+    JournalWriter journal;
+    if(!headless.recordPath.empty()
+            && !journal.open(headless.recordPath, { seed, headless.worldLimits,
+                headless.enemies, headless.hounds, headless.levelPath, headless.swoopers, headless.guards,
+                headless.history }))
+    {
+        cerr << "Could not write " << headless.recordPath << endl;
+        return EXIT_FAILURE;
+    }
+
+    World& world = *worldPointer;
+    Parser parser{};
+    world.setViewport(viewport);
+    world.setThreadPool(&pool);
+    world.setFog(headless.fog);
+    world.setHistoryDepth(headless.history);
+
+    bool eventsOk;
+    auto events = openEventLog(headless, eventsOk);
+    if(!eventsOk)
+        return EXIT_FAILURE;
+    world.setEventLog(events.get());
+
+    if(realtime.enabled)
+    {
+        bool ok = runRealtime(world, parser, renderer, realtime, journal);
+        world.setEventLog(nullptr);
+        return closeEventLog(events.get()) && ok ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    string temp;
+    cout << "Game starting... Type anything to continue\n" << endl;
+    cin  >> temp;
+
+    world.setShouldDrawEntities(true);
+
+    for(;;)
+    {
+        string input;
+        auto& frame = renderer.frame();
+        auto player = world.getPlayer(0);
+
+        world.resetWorldMap();
+
+        player->checkCollisions(world);
+        player->drawStatus(frame);
+
+        world.EnemiesTurn(); 
+        world.drawPlayerActions();
+
+        world.drawMap(frame);
+        world.drawMessages(frame);
+        world.drawWorldInformation(frame);
+        frame << "\tFrame bytes : " << renderer.getLastFrameBytes() << endl;
+        PROFILE_SUMMARY(frame);
+
+        renderer.present();
+        getline(cin, input);
+
+        // Players turn
+        bool keepGoing = parser.parseCommand(input, world);
+        PROFILE_END_TURN();
+        if(journal.isOpen())
+            journal.record(input, world.stateHash());
+        if(!keepGoing)
+            break;
+    }
+
+    world.setEventLog(nullptr);
+    return closeEventLog(events.get()) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,260 @@
+#pragma once
+
+#include "renderer.h"
+
+// Command words understood by the parser, aliases map to the same verb.
+enum class Verb : uint8_t {
+    NONE,
+    QUIT,
+    LEFT,
+    RIGHT,
+    DOWN,
+    UP,
+    BACK,
+    ATTACK,
+    SAVE,
+    LOAD,
+    CONE,
+    BURST,
+    UNDO,
+};
+
+struct VerbEntry
+{
+    string_view name;
+    Verb verb;
+};
+
+constexpr VerbEntry verbs[] = {
+    { "quit",   Verb::QUIT   },
+    { "left",   Verb::LEFT   }, { "l", Verb::LEFT   },
+    { "right",  Verb::RIGHT  }, { "r", Verb::RIGHT  },
+    { "down",   Verb::DOWN   }, { "d", Verb::DOWN   },
+    { "up",     Verb::UP     }, { "u", Verb::UP     },
+    { "back",   Verb::BACK   }, { "b", Verb::BACK   },
+    { "attack", Verb::ATTACK }, { "a", Verb::ATTACK },
+    { "save",   Verb::SAVE   },
+    { "load",   Verb::LOAD   },
+    { "cone",   Verb::CONE   }, { "c", Verb::CONE   },
+    { "burst",  Verb::BURST  },
+    { "undo",   Verb::UNDO   },
+};
+
+// Perfect hash over the verbs above, picked so that no two of them
+// share a bucket. Adding a verb may need new constants, the
+// static_assert below catches it.
+constexpr size_t VERB_TABLE_SIZE = 64;
+
+constexpr size_t verbHash(string_view word)
+{
+    return (word.size() + static_cast<unsigned char>(word.front())
+            + static_cast<unsigned char>(word.back()) * 10) % VERB_TABLE_SIZE;
+}
+
+constexpr array<VerbEntry, VERB_TABLE_SIZE> buildVerbTable()
+{
+    array<VerbEntry, VERB_TABLE_SIZE> table{};
+    for(auto& entry : verbs)
+        table[verbHash(entry.name)] = entry;
+    return table;
+}
+
+constexpr bool verbTableIsPerfect()
+{
+    auto table = buildVerbTable();
+    for(auto& entry : verbs)
+    {
+        if(table[verbHash(entry.name)].name != entry.name)
+            return false;
+    }
+    return true;
+}
+
+constexpr array<VerbEntry, VERB_TABLE_SIZE> verbTable = buildVerbTable();
+static_assert(verbTableIsPerfect(), "verb hash has collisions");
+
+inline Verb lookupVerb(string_view word)
+{
+    if(word.empty())
+        return Verb::NONE;
+    auto& entry = verbTable[verbHash(word)];
+    return entry.name == word ? entry.verb : Verb::NONE;
+}
+
+class Parser {
+
+private:
+    Helper helper{};
+
+    // Returns false when the game should stop.
+    using Handler = bool (Parser::*)(Player&, World&, Verb, string_view);
+
+    bool handleNone(Player&, World&, Verb, string_view) { return true; }
+
+    // Only "quit" on its own stops, "quit now" is no command at all.
+    bool handleQuit(Player&, World&, Verb, string_view argument) { return !argument.empty(); }
+
+    bool handleMove(Player& player, World& world, Verb verb, string_view)
+    {
+        // Height first [ Because scene is a vector< string > ]
+        // then width 
+        position oldPosition = player.getPosition();
+        position delta = moveDeltas_[static_cast<size_t>(verb)];
+        position newPosition = Entity::clampPosition(pair(oldPosition.first + delta.first,
+                    oldPosition.second + delta.second), world.getWorldLimits());
+
+        // Walking into a wall does nothing.
+        if(world.isPassable(newPosition))
+            player.setPosition(newPosition, world.getWorldLimits());
+        return true;
+    }
+
+    bool handleBack(Player& player, World& world, Verb, string_view)
+    {
+        player.moveBackOnePosition(world);
+        return true;
+    }
+
+    // "attack DIRECTION", "cone DIRECTION" and "burst".
+    bool handleAttack(Player& player, World& world, Verb verb, string_view argument)
+    {
+        const AttackPattern* pattern = attackPatterns_[static_cast<size_t>(verb)];
+        int8_t facing = pattern->directional
+            ? facings_[static_cast<size_t>(lookupVerb(argument))]
+            : static_cast<int8_t>(Facing::UP);
+        if(facing >= 0)
+            player.attack(*pattern, static_cast<Facing>(facing), world);
+        return true;
+    }
+
+    // "save [file]" and "load [file]", the file defaults to save.dat.
+    bool handleSave(Player&, World& world, Verb, string_view argument)
+    {
+        if(!fileCommands_)
+            return true;
+        string path(argument.empty() ? DEFAULT_SAVE : argument);
+        world.setWorldMessage(world.save(path) ? "Saved to " + path : "Could not save to " + path);
+        return true;
+    }
+
+    // Loading replaces every player, the Player& passed in is
+    // dangling afterwards.
+    bool handleLoad(Player&, World& world, Verb, string_view argument)
+    {
+        if(!fileCommands_)
+            return true;
+        string path(argument.empty() ? DEFAULT_SAVE : argument);
+        world.setWorldMessage(world.load(path) ? "Loaded " + path : "Could not load " + path);
+        return true;
+    }
+
+    // "undo [turns]", one turn when no count is given. Replaces every
+    // player like loading does.
+    bool handleUndo(Player&, World& world, Verb, string_view argument)
+    {
+        size_t turns = 1;
+        if(!argument.empty())
+        {
+            auto [end, error] = from_chars(argument.data(), argument.data() + argument.size(), turns);
+            if(error != errc() || end != argument.data() + argument.size())
+            {
+                world.setWorldMessage("Undo how many turns?");
+                return true;
+            }
+        }
+
+        size_t kept = world.getUndoDepth();
+        if(!world.hasHistory())
+            world.setWorldMessage("Undo is off, start with --history TURNS");
+        else if(turns == 0 || turns > kept)
+            world.setWorldMessage("Can only undo " + to_string(kept) + (kept == 1 ? " turn" : " turns"));
+        else if(world.undo(turns))
+            world.setWorldMessage("Went back " + to_string(turns) + (turns == 1 ? " turn" : " turns"));
+        else
+            world.setWorldMessage("Could not undo");
+        return true;
+    }
+
+    static constexpr string_view DEFAULT_SAVE = "save.dat";
+
+    // Off on the server, a client shouldn't write files there or
+    // swap the world out from under everyone else.
+    bool fileCommands_ = true;
+
+    // Indexed by Verb.
+    static constexpr Handler handlers_[] = {
+        &Parser::handleNone,
+        &Parser::handleQuit,
+        &Parser::handleMove,
+        &Parser::handleMove,
+        &Parser::handleMove,
+        &Parser::handleMove,
+        &Parser::handleBack,
+        &Parser::handleAttack,
+        &Parser::handleSave,
+        &Parser::handleLoad,
+        &Parser::handleAttack,
+        &Parser::handleAttack,
+        &Parser::handleUndo,
+    };
+
+    static constexpr position moveDeltas_[] = {
+        {0, 0}, {0, 0}, {0, -1}, {0, 1}, {1, 0}, {-1, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0},
+        {0, 0}, {0, 0}, {0, 0},
+    };
+
+    static constexpr const AttackPattern* attackPatterns_[] = {
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, &SWING, nullptr, nullptr,
+        &CONE, &BURST, nullptr,
+    };
+
+    // -1 where the verb isn't a direction.
+    static constexpr int8_t facings_[] = {
+        -1, -1, static_cast<int8_t>(Facing::LEFT), static_cast<int8_t>(Facing::RIGHT),
+        static_cast<int8_t>(Facing::DOWN), static_cast<int8_t>(Facing::UP), -1, -1, -1, -1,
+        -1, -1, -1,
+    };
+
+public:
+    Parser() = default;
+
+    string_view trim(string_view str)
+    {
+        size_t begin = str.find_first_not_of(' ');
+        if(begin == string_view::npos)
+            return string_view();
+        size_t end = str.find_last_not_of(' ');
+        return str.substr(begin, end - begin + 1);
+    }
+
+    void setFileCommands(bool value)
+    {
+        fileCommands_ = value;
+    }
+
+    // Returns false once the player asked to quit.
+    bool parseCommand(string_view input, World& world)
+    {
+        world.clearPlayerAttacks();
+        return parsePlayerCommand(input, world, 0);
+    }
+
+    // Same as parseCommand for any player, attacks from the last
+    // turn are left for the caller to clear.
+    bool parsePlayerCommand(string_view input, World& world, size_t playerIndex)
+    {
+        PROFILE_SCOPE(PARSE_COMMAND);
+        string_view tInput = trim(input);
+        auto player = world.getPlayer(playerIndex);
+
+        string_view tokens[2];
+        size_t count = helper.splitString(tInput, ' ', tokens, 2);
+        if(count == 0)
+            return true;
+
+        Verb verb = lookupVerb(tokens[0]);
+        return (this->*handlers_[static_cast<size_t>(verb)])(*player, world, verb,
+                count > 1 ? tokens[1] : string_view());
+    }
+
+};
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "world.h"
+
+// Plays the player with a fixed policy so the turn loop can run
+// without anyone typing : attack an enemy in reach, otherwise wander.
+class PlayerBot
+{
+
+private:
+
+    mt19937 gen_;
+
+    static constexpr string_view directions_[] = { "up", "down", "left", "right" };
+    static constexpr string_view attacks_[] = { "attack up", "attack down", "attack left", "attack right" };
+    static constexpr position offsets_[] = { {-1, 0}, {1, 0}, {0, -1}, {0, 1} };
+
+public:
+
+    explicit PlayerBot(unsigned seed) : gen_(seed) {}
+
+    string_view nextCommand(World& world, size_t playerIndex)
+    {
+        position playerPosition = world.getPlayer(playerIndex)->getPosition();
+
+        for(int dir = 0; dir < 4; dir++)
+        {
+            for(int reach = 1; reach <= 2; reach++)
+            {
+                position target(playerPosition.first + offsets_[dir].first * reach,
+                        playerPosition.second + offsets_[dir].second * reach);
+                if(world.hasEnemyAt(target))
+                    return attacks_[dir];
+            }
+        }
+
+        if(gen_() % 10 == 0)
+            return "back";
+        return directions_[gen_() % 4];
+    }
+};
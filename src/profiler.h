@@ -0,0 +1,260 @@
+#pragma once
+
+#include "common.h"
+
+// Turn profiler, built in with -DTURN_PROFILER and gone otherwise,
+// the macros below expand to nothing. Phases are timed by scoped
+// timers and counters add up over a turn. The HUD shows averages of
+// the last ROLLING turns, --trace FILE also keeps every timed phase
+// and writes them as Chrome trace events (chrome://tracing, Perfetto).
+#if defined(TURN_PROFILER)
+
+enum class ProfilePhase : uint8_t
+{
+    CHECK_COLLISIONS,
+    ENEMIES_TURN,
+    FLOW_FIELD,
+    DECIDE,
+    COMMIT,
+    PLAYER_ACTIONS,
+    DRAW_MAP,
+    DRAW_MESSAGES,
+    PARSE_COMMAND,
+    PRESENT,
+    BEHAVIOURS,
+    RECORD_TURN,
+    COUNT
+};
+
+enum class ProfileCounter : uint8_t
+{
+    ENTITIES,   // iterated by the turn
+    CELLS,      // map cells written
+    BYTES,      // sent to the terminal or a client
+    COUNT
+};
+
+class TurnProfiler
+{
+
+private:
+
+    static constexpr size_t PHASES   = static_cast<size_t>(ProfilePhase::COUNT);
+    static constexpr size_t COUNTERS = static_cast<size_t>(ProfileCounter::COUNT);
+    static constexpr size_t ROLLING  = 64;
+
+    static constexpr const char* phaseNames_[PHASES] = {
+        "checkCollisions", "EnemiesTurn", "updateFlowField", "decideEnemies",
+        "commitEnemies", "drawPlayerActions", "drawMap", "drawMessages",
+        "parseCommand", "present", "runBehaviours", "recordTurn",
+    };
+    static constexpr const char* counterNames_[COUNTERS] = { "entities", "cells", "bytes" };
+
+    struct TurnTotals
+    {
+        array<uint64_t, PHASES> nanoseconds{};
+        array<uint64_t, COUNTERS> counts{};
+    };
+
+    // Times are nanoseconds since the profiler started, PHASES stands
+    // for the whole turn.
+    struct TraceEvent
+    {
+        uint64_t start;
+        uint64_t duration;
+        uint8_t phase;
+    };
+
+    struct TurnSample
+    {
+        uint64_t end;
+        array<uint64_t, COUNTERS> counts;
+    };
+
+    chrono::steady_clock::time_point origin_ = chrono::steady_clock::now();
+    TurnTotals current_;
+    array<TurnTotals, ROLLING> history_{};
+    size_t turns_ = 0;
+    uint64_t turnStart_ = 0;
+
+    string tracePath_;
+    vector<TraceEvent> events_;
+    vector<TurnSample> samples_;
+
+public:
+
+    uint64_t now() const
+    {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - origin_).count();
+    }
+
+    void record(ProfilePhase phase, uint64_t start, uint64_t end)
+    {
+        current_.nanoseconds[static_cast<size_t>(phase)] += end - start;
+        if(!tracePath_.empty())
+            events_.push_back({ start, end - start, static_cast<uint8_t>(phase) });
+    }
+
+    void count(ProfileCounter counter, uint64_t amount)
+    {
+        current_.counts[static_cast<size_t>(counter)] += amount;
+    }
+
+    void endTurn()
+    {
+        uint64_t end = now();
+        if(!tracePath_.empty())
+        {
+            events_.push_back({ turnStart_, end - turnStart_, static_cast<uint8_t>(PHASES) });
+            samples_.push_back({ end, current_.counts });
+        }
+
+        history_[turns_ % ROLLING] = current_;
+        current_ = TurnTotals{};
+        turns_++;
+        turnStart_ = end;
+    }
+
+    void startTrace(const string& path)
+    {
+        tracePath_ = path;
+        events_.reserve(1 << 16);
+        turnStart_ = now();
+    }
+
+    void drawSummary(ostream& out) const
+    {
+        size_t turns = min(turns_, ROLLING);
+        if(turns == 0)
+            return;
+
+        TurnTotals sum;
+        for(size_t i = 0; i < turns; i++)
+        {
+            for(size_t phase = 0; phase < PHASES; phase++)
+                sum.nanoseconds[phase] += history_[i].nanoseconds[phase];
+            for(size_t counter = 0; counter < COUNTERS; counter++)
+                sum.counts[counter] += history_[i].counts[counter];
+        }
+
+        out << "\tProfile, us per turn over the last " << turns << " turns :\n";
+        for(size_t phase = 0; phase < PHASES; phase++)
+        {
+            out << (phase % 4 == 0 ? "\t  " : "  ") << phaseNames_[phase] << ' '
+                << fixed << setprecision(1) << sum.nanoseconds[phase] / 1e3 / turns << defaultfloat;
+            if(phase % 4 == 3 || phase + 1 == PHASES)
+                out << '\n';
+        }
+        out << "\t ";
+        for(size_t counter = 0; counter < COUNTERS; counter++)
+            out << ' ' << counterNames_[counter] << ' ' << sum.counts[counter] / turns;
+        out << '\n';
+    }
+
+    bool writeTrace() const
+    {
+        if(tracePath_.empty())
+            return true;
+
+        ofstream output(tracePath_, ios::trunc);
+        output << fixed << setprecision(3) << "{\"traceEvents\":[\n";
+
+        bool first = true;
+        auto separator = [&]() -> ostream& {
+            output << (first ? "" : ",\n");
+            first = false;
+            return output;
+        };
+
+        for(auto& event : events_)
+        {
+            separator() << "{\"name\":\"" << (event.phase < PHASES ? phaseNames_[event.phase] : "turn")
+                        << "\",\"cat\":\"turn\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"
+                        << event.start / 1e3 << ",\"dur\":" << event.duration / 1e3 << '}';
+        }
+        for(auto& sample : samples_)
+        {
+            separator() << "{\"name\":\"counters\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":"
+                        << sample.end / 1e3 << ",\"args\":{";
+            for(size_t counter = 0; counter < COUNTERS; counter++)
+            {
+                output << (counter ? "," : "") << '"' << counterNames_[counter] << "\":"
+                       << sample.counts[counter];
+            }
+            output << "}}";
+        }
+        output << "\n]}\n";
+
+        if(!output)
+        {
+            cerr << "Could not write " << tracePath_ << endl;
+            return false;
+        }
+        cout << "Wrote " << events_.size() << " trace events to " << tracePath_ << endl;
+        return true;
+    }
+};
+
+// One per thread, rooms on a pool don't share theirs.
+inline TurnProfiler& turnProfiler()
+{
+    thread_local TurnProfiler profiler;
+    return profiler;
+}
+
+class ProfileScope
+{
+
+private:
+
+    ProfilePhase phase_;
+    uint64_t start_;
+
+public:
+
+    explicit ProfileScope(ProfilePhase phase)
+        : phase_(phase), start_(turnProfiler().now()) {}
+
+    ~ProfileScope()
+    {
+        TurnProfiler& profiler = turnProfiler();
+        profiler.record(phase_, start_, profiler.now());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+};
+
+// Writes the trace when main returns, whichever mode it ran.
+class ProfileTrace
+{
+
+public:
+
+    explicit ProfileTrace(const string& path)
+    {
+        if(!path.empty())
+            turnProfiler().startTrace(path);
+    }
+
+    ~ProfileTrace()
+    {
+        turnProfiler().writeTrace();
+    }
+};
+
+#define PROFILE_JOIN_(a, b) a##b
+#define PROFILE_JOIN(a, b) PROFILE_JOIN_(a, b)
+#define PROFILE_SCOPE(phase) ProfileScope PROFILE_JOIN(profileScope, __LINE__)(ProfilePhase::phase)
+#define PROFILE_COUNT(counter, amount) turnProfiler().count(ProfileCounter::counter, (amount))
+#define PROFILE_END_TURN() turnProfiler().endTurn()
+#define PROFILE_SUMMARY(out) turnProfiler().drawSummary(out)
+
+#else
+
+#define PROFILE_SCOPE(phase)
+#define PROFILE_COUNT(counter, amount)
+#define PROFILE_END_TURN()
+#define PROFILE_SUMMARY(out)
+
+#endif
@@ -0,0 +1,294 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "realtime.h"
+
+// Puts stdin in non canonical, no echo, non blocking mode while
+// alive, keys arrive one at a time without Enter. Only the blocking
+// flag is touched when stdin isn't a terminal.
+class RawTerminal
+{
+
+private:
+
+    termios saved_{};
+    bool restoreTerminal_ = false;
+    int savedFlags_ = -1;
+
+public:
+
+    RawTerminal()
+    {
+        if(isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &saved_) == 0)
+        {
+            termios raw = saved_;
+            raw.c_lflag &= ~(ICANON | ECHO);
+            raw.c_cc[VMIN]  = 0;
+            raw.c_cc[VTIME] = 0;
+            restoreTerminal_ = tcsetattr(STDIN_FILENO, TCSANOW, &raw) == 0;
+        }
+
+        savedFlags_ = fcntl(STDIN_FILENO, F_GETFL);
+        if(savedFlags_ >= 0)
+            fcntl(STDIN_FILENO, F_SETFL, savedFlags_ | O_NONBLOCK);
+    }
+
+    ~RawTerminal()
+    {
+        if(savedFlags_ >= 0)
+            fcntl(STDIN_FILENO, F_SETFL, savedFlags_);
+        if(restoreTerminal_)
+            tcsetattr(STDIN_FILENO, TCSANOW, &saved_);
+    }
+
+    RawTerminal(const RawTerminal&) = delete;
+    RawTerminal& operator=(const RawTerminal&) = delete;
+};
+
+// Turns key presses into parser commands. WASD or the arrows move,
+// IJKL swing, shifted IJKL throw a cone, x bursts, b steps back and
+// q quits.
+class KeyReader
+{
+
+private:
+
+    static constexpr size_t QUEUE_SIZE = 8;
+
+    array<string_view, QUEUE_SIZE> queue_{};
+    size_t head_ = 0;
+    size_t count_ = 0;
+    size_t dropped_ = 0;
+
+    // 0 plain, 1 after ESC, 2 after ESC [
+    int escape_ = 0;
+
+    void enqueue(string_view command)
+    {
+        if(command.empty())
+            return;
+        if(count_ == QUEUE_SIZE)
+        {
+            dropped_++;
+            return;
+        }
+        queue_[(head_ + count_++) % QUEUE_SIZE] = command;
+    }
+
+    static string_view commandFor(char key)
+    {
+        switch(key)
+        {
+            case 'w': return "up";
+            case 'a': return "left";
+            case 's': return "down";
+            case 'd': return "right";
+            case 'i': return "attack up";
+            case 'j': return "attack left";
+            case 'k': return "attack down";
+            case 'l': return "attack right";
+            case 'I': return "cone up";
+            case 'J': return "cone left";
+            case 'K': return "cone down";
+            case 'L': return "cone right";
+            case 'x': return "burst";
+            case 'b': return "back";
+            case 'q': return "quit";
+            default:  return string_view();
+        }
+    }
+
+    static string_view commandForArrow(char key)
+    {
+        switch(key)
+        {
+            case 'A': return "up";
+            case 'B': return "down";
+            case 'C': return "right";
+            case 'D': return "left";
+            default:  return string_view();
+        }
+    }
+
+public:
+
+    // Reads whatever is waiting, false once input is closed.
+    bool poll()
+    {
+        char buffer[64];
+        for(;;)
+        {
+            ssize_t count = read(STDIN_FILENO, buffer, sizeof(buffer));
+            if(count == 0)
+                return false;
+            if(count < 0)
+                return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+            for(ssize_t i = 0; i < count; i++)
+            {
+                char key = buffer[i];
+                if(escape_ == 1)
+                    escape_ = key == '[' ? 2 : 0;
+                else if(escape_ == 2)
+                {
+                    enqueue(commandForArrow(key));
+                    escape_ = 0;
+                }
+                else if(key == '\x1B')
+                    escape_ = 1;
+                else
+                    enqueue(commandFor(key));
+            }
+        }
+    }
+
+    // One command per tick, empty when nothing was pressed.
+    string_view next()
+    {
+        if(count_ == 0)
+            return string_view();
+        string_view command = queue_[head_];
+        head_ = (head_ + 1) % QUEUE_SIZE;
+        count_--;
+        return command;
+    }
+
+    size_t getDropped() const { return dropped_; }
+};
+
+bool runRealtime(World& world, Parser& parser, Renderer& renderer,
+        const RealtimeOptions& options, JournalWriter& journal)
+{
+    using Clock = chrono::steady_clock;
+    constexpr long MAX_BEHIND = 2;
+    constexpr size_t WINDOW = 128;
+
+    const auto tickPeriod  = chrono::nanoseconds(1000000000L / max(1, options.tickRate));
+    const auto framePeriod = chrono::nanoseconds(1000000000L / max(1, options.frameRate));
+    const double tickPeriodMs = chrono::duration<double, milli>(tickPeriod).count();
+    const double framePeriodMs = chrono::duration<double, milli>(framePeriod).count();
+
+    vector<double> tickWork, tickLateness, frameJitter;
+    array<double, WINDOW> recentLateness{}, recentJitter{};
+    long ticks = 0, overruns = 0, skipped = 0, frames = 0;
+
+    auto windowMax = [](const array<double, WINDOW>& window) {
+        return *max_element(window.begin(), window.end());
+    };
+
+    KeyReader keys;
+    bool running = true;
+    bool inputOpen = true;
+    {
+        RawTerminal terminal;
+        world.setShouldDrawEntities(true);
+
+        auto start = Clock::now();
+        auto nextTick = start;
+        auto nextFrame = start;
+        auto lastFrame = start;
+
+        while(running && (options.ticks == 0 || ticks < options.ticks))
+        {
+            auto now = Clock::now();
+            if(now >= nextTick)
+            {
+                double lateness = chrono::duration<double, milli>(now - nextTick).count();
+                tickLateness.push_back(lateness);
+                recentLateness[ticks % WINDOW] = lateness;
+
+                world.resetWorldMap();
+                world.getPlayer(0)->checkCollisions(world);
+                world.EnemiesTurn();
+                string_view command = keys.next();
+                running = parser.parseCommand(command, world);
+                world.drawPlayerActions();
+                PROFILE_END_TURN();
+                if(journal.isOpen())
+                    journal.record(command, world.stateHash());
+
+                auto done = Clock::now();
+                double work = chrono::duration<double, milli>(done - now).count();
+                tickWork.push_back(work);
+                if(work > tickPeriodMs)
+                    overruns++;
+                ticks++;
+
+                nextTick += tickPeriod;
+                if(done - nextTick > tickPeriod * MAX_BEHIND)
+                {
+                    long behind = (done - nextTick) / tickPeriod;
+                    skipped += behind;
+                    nextTick += tickPeriod * behind;
+                }
+                continue;
+            }
+
+            if(now >= nextFrame)
+            {
+                if(frames > 0)
+                {
+                    double jitter = fabs(chrono::duration<double, milli>(now - lastFrame).count() - framePeriodMs);
+                    frameJitter.push_back(jitter);
+                    recentJitter[frames % WINDOW] = jitter;
+                }
+                lastFrame = now;
+                frames++;
+
+                auto& frame = renderer.frame();
+                world.getPlayer(0)->drawStatus(frame);
+                world.drawMap(frame);
+                world.drawMessages(frame);
+                world.drawWorldInformation(frame);
+                frame << "\tFrame bytes : " << renderer.getLastFrameBytes() << '\n';
+                frame << fixed << setprecision(2)
+                      << "\tTicks : " << ticks << " at " << options.tickRate << " Hz, "
+                      << overruns << " overruns, " << skipped << " skipped\n"
+                      << "\tLate max " << windowMax(recentLateness) << " ms, frame jitter max "
+                      << windowMax(recentJitter) << " ms (last " << WINDOW << ")\n" << defaultfloat;
+                PROFILE_SUMMARY(frame);
+                renderer.present();
+
+                nextFrame += framePeriod;
+                if(nextFrame < now)
+                    nextFrame = now + framePeriod;
+                continue;
+            }
+
+            // Sleeps until the next tick or frame, a key wakes it early.
+            // Closed input ends the game, unless a tick count was given.
+            auto wait = chrono::duration_cast<chrono::nanoseconds>(min(nextTick, nextFrame) - now);
+            timespec timeout{ static_cast<time_t>(wait.count() / 1000000000L),
+                static_cast<long>(wait.count() % 1000000000L) };
+            pollfd input{ inputOpen ? STDIN_FILENO : -1, POLLIN, 0 };
+            if(ppoll(&input, 1, &timeout, nullptr) > 0 && !keys.poll())
+            {
+                inputOpen = false;
+                running = options.ticks > 0;
+            }
+        }
+    }
+
+    auto percentile = [](vector<double>& values, double p) {
+        if(values.empty())
+            return 0.0;
+        sort(values.begin(), values.end());
+        return values[static_cast<size_t>(p * (values.size() - 1))];
+    };
+
+    cout << "ticks         : " << ticks << " at " << options.tickRate << " Hz, "
+         << frames << " frames at " << options.frameRate << " Hz" << endl;
+    cout << "overruns      : " << overruns << " (" << skipped << " ticks skipped)" << endl;
+    cout << "tick work     : " << percentile(tickWork, 0.50) << " / " << percentile(tickWork, 0.99)
+         << " ms (p50 / p99)" << endl;
+    cout << "tick lateness : " << percentile(tickLateness, 0.50) << " / " << percentile(tickLateness, 0.99)
+         << " ms (p50 / p99)" << endl;
+    cout << "frame jitter  : " << percentile(frameJitter, 0.50) << " / " << percentile(frameJitter, 0.99)
+         << " ms (p50 / p99)" << endl;
+    if(keys.getDropped() > 0)
+        cout << "keys dropped  : " << keys.getDropped() << endl;
+    return true;
+}
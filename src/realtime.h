@@ -0,0 +1,19 @@
+#pragma once
+
+#include "journal.h"
+#include "parser.h"
+
+struct RealtimeOptions
+{
+    bool enabled = false;
+    int tickRate = 20;      // simulation ticks per second
+    int frameRate = 60;     // frames drawn per second
+    long ticks = 0;         // 0 keeps going until quit
+};
+
+// Simulation ticks on a fixed step whether or not a key was pressed,
+// frames are drawn on their own step. Ticks come first when both are
+// due. A tick that starts more than MAX_BEHIND steps late drops the
+// backlog instead of bursting through it, so the rate stays steady.
+bool runRealtime(World& world, Parser& parser, Renderer& renderer,
+        const RealtimeOptions& options, JournalWriter& journal);
@@ -0,0 +1,213 @@
+#pragma once
+
+#include <errno.h>
+#include <unistd.h>
+
+#include "world.h"
+
+// Collects everything drawn during a turn and sends it to the
+// terminal with a single write. Only the cells that changed since
+// the last presented frame are sent, unless full redraw is on.
+class Renderer
+{
+
+private:
+
+    // Appends whatever is streamed into it to a string
+    // that keeps its capacity between frames.
+    class FrameBuffer : public streambuf
+    {
+
+    public:
+
+        string text_;
+
+    protected:
+
+        int_type overflow(int_type ch) override
+        {
+            if(ch != traits_type::eof())
+                text_.push_back(static_cast<char>(ch));
+            return ch;
+        }
+
+        streamsize xsputn(const char* str, streamsize count) override
+        {
+            text_.append(str, count);
+            return count;
+        }
+    };
+
+    // Unchanged gaps shorter than this are resent
+    // instead of paying for another cursor move.
+    static constexpr size_t MERGE_GAP = 4;
+    static constexpr size_t TAB_WIDTH = 8;
+
+    FrameBuffer buffer_;
+    ostream frame_{&buffer_};
+
+    vector<string> lines_;
+    vector<string> presented_;
+    size_t lineCount_ = 0;
+    size_t presentedCount_ = 0;
+
+    string out_;
+
+    bool fullRedraw_ = false;
+    bool hasPresented_ = false;
+    size_t lastFrameBytes_ = 0;
+
+    // Tabs are expanded so a column in the
+    // frame is a column on the terminal.
+    void splitLines()
+    {
+        lineCount_ = 0;
+        size_t begin = 0;
+        const string& text = buffer_.text_;
+
+        while(begin < text.size())
+        {
+            size_t end = text.find('\n', begin);
+            if(end == string::npos)
+                end = text.size();
+
+            if(lineCount_ == lines_.size())
+                lines_.emplace_back();
+
+            string& line = lines_[lineCount_++];
+            line.clear();
+            for(size_t i = begin; i < end; i++)
+            {
+                if(text[i] == '\t')
+                    line.append(TAB_WIDTH - line.size() % TAB_WIDTH, ' ');
+                else
+                    line.push_back(text[i]);
+            }
+
+            begin = end + 1;
+        }
+    }
+
+    void moveCursor(size_t row, size_t column)
+    {
+        out_ += "\x1B[";
+        out_ += to_string(row + 1);
+        out_ += ';';
+        out_ += to_string(column + 1);
+        out_ += 'H';
+    }
+
+    void diffLine(size_t row, string_view before, string_view now)
+    {
+        size_t column = 0;
+        while(column < now.size())
+        {
+            if(column < before.size() && before[column] == now[column])
+            {
+                column++;
+                continue;
+            }
+
+            size_t runEnd = column + 1;
+            for(size_t i = runEnd; i < now.size(); i++)
+            {
+                if(i < before.size() && before[i] == now[i])
+                {
+                    if(i + 1 - runEnd > MERGE_GAP)
+                        break;
+                }
+                else
+                    runEnd = i + 1;
+            }
+
+            moveCursor(row, column);
+            out_.append(now.substr(column, runEnd - column));
+            column = runEnd;
+        }
+
+        if(now.size() < before.size())
+        {
+            moveCursor(row, now.size());
+            out_ += "\x1B[K";
+        }
+    }
+
+    void writeAll()
+    {
+        size_t written = 0;
+        while(written < out_.size())
+        {
+            ssize_t count = ::write(STDOUT_FILENO, out_.data() + written,
+                    out_.size() - written);
+            if(count < 0)
+            {
+                if(errno == EINTR)
+                    continue;
+                break;
+            }
+            written += count;
+        }
+    }
+
+public:
+
+    ostream& frame()
+    {
+        return frame_;
+    }
+
+    void setFullRedraw(bool value)
+    {
+        fullRedraw_ = value;
+    }
+
+    size_t getLastFrameBytes() const
+    {
+        return lastFrameBytes_;
+    }
+
+    void present()
+    {
+        PROFILE_SCOPE(PRESENT);
+        splitLines();
+        out_.clear();
+
+        if(fullRedraw_ || !hasPresented_)
+        {
+            out_ += "\x1B[2J\x1B[H";
+            for(size_t row = 0; row < lineCount_; row++)
+            {
+                out_ += lines_[row];
+                out_ += '\n';
+            }
+        }
+        else
+        {
+            size_t rows = max(lineCount_, presentedCount_);
+            for(size_t row = 0; row < rows; row++)
+            {
+                string_view before = row < presentedCount_ ? string_view(presented_[row]) : string_view();
+                string_view now    = row < lineCount_ ? string_view(lines_[row]) : string_view();
+                diffLine(row, before, now);
+            }
+
+            // Park the cursor under the frame and wipe
+            // whatever was typed there last turn.
+            moveCursor(lineCount_, 0);
+            out_ += "\x1B[J";
+        }
+
+        writeAll();
+
+        if(presented_.size() < lineCount_)
+            presented_.resize(lineCount_);
+        for(size_t row = 0; row < lineCount_; row++)
+            presented_[row].assign(lines_[row]);
+        presentedCount_ = lineCount_;
+
+        hasPresented_   = true;
+        lastFrameBytes_ = out_.size();
+        PROFILE_COUNT(BYTES, lastFrameBytes_);
+        buffer_.text_.clear();
+    }
+};
@@ -0,0 +1,313 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "parser.h"
+#include "player_bot.h"
+#include "rooms.h"
+#include "setup.h"
+#include "work_stealing_pool.h"
+
+// One independent game played by a bot. A room is only touched by
+// the job running it, so its whole turn stays on one thread.
+class Room
+{
+
+private:
+
+    const HeadlessOptions& setup_;
+    uint32_t id_;
+    unsigned seed_;
+    long lifetime_;
+
+    unique_ptr<World> world_;
+    Parser parser_{};
+    PlayerBot bot_;
+
+    long turns_ = 0;
+    double turnSeconds_ = 0;
+    int64_t heapBytes_ = 0;
+    bool failed_ = false;
+
+public:
+
+    Room(const HeadlessOptions& setup, uint32_t id, unsigned seed, long lifetime)
+        : setup_(setup), id_(id), seed_(seed), lifetime_(lifetime), bot_(seed) {}
+
+    void open()
+    {
+        int64_t heapBefore = threadHeapBytes;
+        world_ = createWorld(setup_.levelPath, setup_.worldLimits, seed_,
+                setup_.enemies, setup_.hounds, setup_.swoopers, setup_.guards);
+        failed_ = !world_;
+        heapBytes_ += threadHeapBytes - heapBefore;
+    }
+
+    void turn()
+    {
+        int64_t heapBefore = threadHeapBytes;
+        auto start = chrono::steady_clock::now();
+
+        World& world = *world_;
+        auto player = world.getPlayer(0);
+        world.resetWorldMap();
+        player->checkCollisions(world);
+        world.EnemiesTurn();
+        parser_.parseCommand(bot_.nextCommand(world, 0), world);
+
+        turnSeconds_ += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        turns_++;
+        heapBytes_ += threadHeapBytes - heapBefore;
+    }
+
+    void close()
+    {
+        int64_t heapBefore = threadHeapBytes;
+        world_.reset();
+        heapBytes_ += threadHeapBytes - heapBefore;
+    }
+
+    bool isFinished() const
+    {
+        return failed_ || turns_ >= lifetime_ || world_->getPlayer(0)->getHealth() <= 0;
+    }
+
+    bool hasFailed() const { return failed_; }
+    uint32_t getId() const { return id_; }
+    unsigned getSeed() const { return seed_; }
+    long getTurns() const { return turns_; }
+    int64_t getHeapBytes() const { return heapBytes_; }
+    size_t getEnemyCount() const { return world_ ? world_->getEnemyCount() : 0; }
+
+    double getTurnRate() const
+    {
+        return turnSeconds_ > 0 ? turns_ / turnSeconds_ : 0.0;
+    }
+};
+
+// Hosts many rooms on a work stealing pool. Every room slot is a
+// task of its own that plays one turn of its room and pushes itself
+// again, so rooms never wait for each other and a slow one only holds
+// up itself. A slot closes its room once it's finished and opens the
+// next one in its place, on whatever thread it's running on. Slots
+// only touch their own room and records, nothing shared is locked.
+class RoomManager
+{
+
+private:
+
+    struct RoomRecord
+    {
+        uint32_t id;
+        unsigned seed;
+        long turns;
+        double turnRate;
+        int64_t heapBytes;
+        bool open;
+    };
+
+    struct Slot
+    {
+        WorkStealingPool::Task task;
+        RoomManager* manager;
+        uint32_t index;
+        mt19937 gen;
+
+        unique_ptr<Room> room;
+        long turnsLeft;
+        long turns = 0;
+        uint32_t opened = 0;
+        long closed = 0;
+        vector<RoomRecord> closedRooms;
+    };
+
+    const HeadlessOptions& setup_;
+    RoomOptions options_;
+    WorkStealingPool& pool_;
+
+    // Sized once, the pool's tasks point into it.
+    unique_ptr<Slot[]> slots_;
+    atomic<long> failed_ {0};
+    double seconds_ = 0;
+
+    static RoomRecord recordOf(const Room& room, bool open)
+    {
+        return { room.getId(), room.getSeed(), room.getTurns(),
+            room.getTurnRate(), room.getHeapBytes(), open };
+    }
+
+    // A slot's rooms get ids index, index + rooms and so on, the same
+    // whichever threads ran them.
+    void openRoom(Slot& slot)
+    {
+        uniform_int_distribution<long> lifetime(max(1L, options_.roomTurns / 2),
+                max(1L, options_.roomTurns * 3 / 2));
+        uint32_t id = slot.opened++ * static_cast<uint32_t>(options_.rooms) + slot.index;
+
+        slot.room = make_unique<Room>(setup_, id, setup_.seed + id, lifetime(slot.gen));
+        slot.room->open();
+        if(slot.room->hasFailed())
+            failed_.fetch_add(1, memory_order_relaxed);
+    }
+
+    void play(Slot& slot)
+    {
+        if(!slot.room)
+        {
+            openRoom(slot);
+            if(slot.room->hasFailed())
+                return;
+        }
+
+        slot.room->turn();
+        slot.turns++;
+        slot.turnsLeft--;
+
+        if(slot.room->isFinished())
+        {
+            slot.room->close();
+            slot.closedRooms.push_back(recordOf(*slot.room, false));
+            slot.room.reset();
+            slot.closed++;
+        }
+    }
+
+    // Stops every slot once a room can't be opened, the next ones
+    // wouldn't open either.
+    static void slotJob(void* context, size_t worker)
+    {
+        Slot& slot = *static_cast<Slot*>(context);
+        RoomManager& manager = *slot.manager;
+        manager.play(slot);
+        if(slot.turnsLeft > 0 && manager.failed_.load(memory_order_relaxed) == 0)
+            manager.pool_.push(worker, slot.task);
+    }
+
+public:
+
+    RoomManager(const HeadlessOptions& setup, const RoomOptions& options, WorkStealingPool& pool)
+        : setup_(setup), options_(options), pool_(pool), slots_(new Slot[options.rooms])
+    {
+        for(size_t i = 0; i < options_.rooms; i++)
+        {
+            Slot& slot = slots_[i];
+            slot.task      = { &RoomManager::slotJob, &slot };
+            slot.manager   = this;
+            slot.index     = static_cast<uint32_t>(i);
+            slot.gen.seed(setup.seed + static_cast<unsigned>(i));
+            slot.turnsLeft = options_.rounds;
+        }
+    }
+
+    // Every slot plays options.rounds turns, rooms still open at
+    // the end stay open until the manager goes.
+    void run()
+    {
+        auto start = chrono::steady_clock::now();
+        for(size_t i = 0; i < options_.rooms; i++)
+        {
+            if(slots_[i].turnsLeft > 0)
+                pool_.submit(slots_[i].task);
+        }
+        pool_.run();
+        seconds_ = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+
+    ~RoomManager()
+    {
+        for(size_t i = 0; i < options_.rooms; i++)
+        {
+            if(slots_[i].room)
+                slots_[i].room->close();
+        }
+    }
+
+    RoomManager(const RoomManager&) = delete;
+    RoomManager& operator=(const RoomManager&) = delete;
+
+    bool printStats() const
+    {
+        vector<RoomRecord> records;
+        long turns = 0, opened = 0, closed = 0, open = 0;
+        for(size_t i = 0; i < options_.rooms; i++)
+        {
+            const Slot& slot = slots_[i];
+            records.insert(records.end(), slot.closedRooms.begin(), slot.closedRooms.end());
+            if(slot.room)
+            {
+                records.push_back(recordOf(*slot.room, true));
+                open++;
+            }
+            turns  += slot.turns;
+            opened += slot.opened;
+            closed += slot.closed;
+        }
+        sort(records.begin(), records.end(), [](auto& a, auto& b) { return a.id < b.id; });
+
+        vector<double> rates;
+        vector<int64_t> openHeap;
+        for(auto& record : records)
+        {
+            if(record.turns > 0)
+                rates.push_back(record.turnRate);
+            if(record.open)
+                openHeap.push_back(record.heapBytes);
+        }
+        sort(rates.begin(), rates.end());
+        sort(openHeap.begin(), openHeap.end());
+
+        auto percentile = [](const auto& values, double p) {
+            using Value = typename decay_t<decltype(values)>::value_type;
+            return values.empty() ? Value() : values[static_cast<size_t>(p * (values.size() - 1))];
+        };
+
+        int64_t heapTotal = accumulate(openHeap.begin(), openHeap.end(), int64_t(0));
+        long failed = failed_.load(memory_order_relaxed);
+
+        cout << "threads       : " << pool_.getThreadCount() << endl;
+        cout << "rooms         : " << open << " open, " << opened << " opened, "
+             << closed << " closed" << endl;
+        cout << "room turns    : " << turns << endl;
+        cout << "wall time     : " << seconds_ * 1e3 << " ms" << endl;
+        cout << "turns/sec     : " << (seconds_ > 0 ? turns / seconds_ : 0.0) << endl;
+        cout << "room rate     : " << percentile(rates, 0.0) << " / " << percentile(rates, 0.5)
+             << " / " << percentile(rates, 1.0) << " turns/sec (min / p50 / max)" << endl;
+        cout << "room heap     : " << percentile(openHeap, 0.0) << " / " << percentile(openHeap, 0.5)
+             << " / " << percentile(openHeap, 1.0) << " bytes (min / p50 / max)" << endl;
+        cout << "heap total    : " << heapTotal << " bytes in open rooms" << endl;
+        cout << "steals        : " << pool_.getStealCount() << endl;
+        cout << "parks         : " << pool_.getParkCount() << endl;
+
+        if(!options_.statsPath.empty())
+        {
+            ofstream output(options_.statsPath, ios::trunc);
+            output << "id,seed,turns,turns_per_sec,heap_bytes,open\n";
+            for(auto& record : records)
+            {
+                output << record.id << ',' << record.seed << ',' << record.turns << ','
+                       << record.turnRate << ',' << record.heapBytes << ','
+                       << (record.open ? 1 : 0) << '\n';
+            }
+            if(!output)
+            {
+                cerr << "Could not write " << options_.statsPath << endl;
+                return false;
+            }
+        }
+
+        if(failed > 0)
+        {
+            cerr << failed << " rooms could not be opened" << endl;
+            return false;
+        }
+        return true;
+    }
+};
+
+bool runRooms(const HeadlessOptions& setup, const RoomOptions& options, size_t threads)
+{
+    heapTracking = true;
+    WorkStealingPool pool{threads};
+    RoomManager manager(setup, options, pool);
+    manager.run();
+    return manager.printStats();
+}
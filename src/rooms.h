@@ -0,0 +1,13 @@
+#pragma once
+
+#include "headless.h"
+
+struct RoomOptions
+{
+    size_t rooms = 0;       // kept open, a closed room is replaced
+    long rounds = 1000;     // turns each of them plays, replacements included
+    long roomTurns = 200;   // average lifetime, each room draws its own
+    string statsPath;
+};
+
+bool runRooms(const HeadlessOptions& setup, const RoomOptions& options, size_t threads);
@@ -0,0 +1,475 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <sys/epoll.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "parser.h"
+#include "server.h"
+#include "setup.h"
+
+bool parseSocketAddress(const string& text, SocketAddress& result)
+{
+    if(text.rfind("unix:", 0) == 0)
+    {
+        sockaddr_un addr{};
+        string path = text.substr(5);
+        if(path.empty() || path.size() >= sizeof(addr.sun_path))
+            return false;
+
+        addr.sun_family = AF_UNIX;
+        memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        memcpy(&result.storage, &addr, sizeof(addr));
+        result.length = sizeof(addr);
+        result.unixPath = path;
+        return true;
+    }
+
+    if(text.rfind("tcp:", 0) == 0)
+    {
+        char* end = nullptr;
+        long port = strtol(text.c_str() + 4, &end, 10);
+        if(*end != '\0' || port <= 0 || port > 65535)
+            return false;
+
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        memcpy(&result.storage, &addr, sizeof(addr));
+        result.length = sizeof(addr);
+        return true;
+    }
+    return false;
+}
+
+void setNoDelay(int fd, const SocketAddress& address)
+{
+    if(address.unixPath.empty())
+    {
+        int on = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+    }
+}
+
+volatile sig_atomic_t serverStopRequested = 0;
+
+void requestServerStop(int)
+{
+    serverStopRequested = 1;
+}
+
+class GameServer
+{
+
+private:
+
+    struct Client
+    {
+        int fd = -1;
+        string input;           // may hold several commands
+        size_t lines = 0;       // complete commands in input
+        string output;          // not sent yet, starts at sent
+        size_t sent = 0;
+        bool writing = false;   // waiting on EPOLLOUT
+        bool closing = false;
+        long commands = 0;
+    };
+
+    static constexpr size_t READ_SIZE = 4096;
+    static constexpr size_t INPUT_LIMIT = 1 << 16;
+    static constexpr size_t OUTPUT_LIMIT = 1 << 20;
+    static constexpr int SPAWN_RADIUS = 8;
+
+    World& world_;
+    ServerOptions options_;
+    SocketAddress address_;
+    Parser parser_{};
+    int listenFd_ = -1;
+    int epollFd_ = -1;
+
+    // Client i plays player slot i, removals swap both the same way.
+    vector<Client> clients_;
+    vector<int32_t> slotOfFd_;
+    size_t waiting_ = 0;
+
+    position spawn_;
+    mt19937 gen_;
+    long nextName_ = 1;
+    ostringstream frame_;
+
+    long rounds_ = 0;
+    long commands_ = 0;
+    size_t peakClients_ = 0;
+    vector<double> roundTimes_;
+
+    void watch(int fd, uint32_t events, int operation)
+    {
+        epoll_event event{};
+        event.events = events;
+        event.data.fd = fd;
+        epoll_ctl(epollFd_, operation, fd, &event);
+    }
+
+    position findSpawn()
+    {
+        uniform_int_distribution<int> offset(-SPAWN_RADIUS, SPAWN_RADIUS);
+        for(int attempt = 0; attempt < 256; attempt++)
+        {
+            position pos(spawn_.first + offset(gen_), spawn_.second + offset(gen_));
+            if(world_.isPassable(pos) && !world_.hasEnemyAt(pos))
+                return pos;
+        }
+        return spawn_;
+    }
+
+    void acceptClients()
+    {
+        for(;;)
+        {
+            int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if(fd < 0)
+                return;
+            setNoDelay(fd, address_);
+
+            Player player("Player " + to_string(nextName_++), 200, 20, 30, findSpawn(), '@');
+            world_.addEntity(player);
+
+            if(static_cast<size_t>(fd) >= slotOfFd_.size())
+                slotOfFd_.resize(fd + 1, -1);
+            slotOfFd_[fd] = static_cast<int32_t>(clients_.size());
+
+            clients_.emplace_back();
+            clients_.back().fd = fd;
+            peakClients_ = max(peakClients_, clients_.size());
+            watch(fd, EPOLLIN, EPOLL_CTL_ADD);
+
+            sendFrame(clients_.size() - 1);
+        }
+    }
+
+    void disconnect(size_t slot)
+    {
+        Client& client = clients_[slot];
+        if(client.lines > 0)
+            waiting_--;
+        epoll_ctl(epollFd_, EPOLL_CTL_DEL, client.fd, nullptr);
+        close(client.fd);
+        slotOfFd_[client.fd] = -1;
+
+        size_t moved = world_.removePlayer(slot);
+        if(moved != EntityStore::npos)
+        {
+            clients_[slot] = move(clients_[moved]);
+            slotOfFd_[clients_[slot].fd] = static_cast<int32_t>(slot);
+        }
+        clients_.pop_back();
+    }
+
+    void readClient(size_t slot)
+    {
+        Client& client = clients_[slot];
+        char buffer[READ_SIZE];
+        for(;;)
+        {
+            ssize_t count = read(client.fd, buffer, sizeof(buffer));
+            if(count > 0)
+            {
+                size_t before = client.lines;
+                client.lines += std::count(buffer, buffer + count, '\n');
+                client.input.append(buffer, count);
+                if(before == 0 && client.lines > 0)
+                    waiting_++;
+                if(client.input.size() > INPUT_LIMIT)
+                    client.closing = true;
+                continue;
+            }
+            if(count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+                return;
+            if(count < 0 && errno == EINTR)
+                continue;
+            client.closing = true;
+            return;
+        }
+    }
+
+    void flushClient(size_t slot)
+    {
+        Client& client = clients_[slot];
+        while(client.sent < client.output.size())
+        {
+            ssize_t count = send(client.fd, client.output.data() + client.sent,
+                    client.output.size() - client.sent, MSG_NOSIGNAL);
+            if(count > 0)
+            {
+                client.sent += count;
+                continue;
+            }
+            if(count < 0 && errno == EINTR)
+                continue;
+            if(count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                if(!client.writing)
+                    watch(client.fd, EPOLLIN | EPOLLOUT, EPOLL_CTL_MOD);
+                client.writing = true;
+                if(client.output.size() - client.sent > OUTPUT_LIMIT)
+                    client.closing = true;
+                return;
+            }
+            client.closing = true;
+            return;
+        }
+
+        client.output.clear();
+        client.sent = 0;
+        if(client.writing)
+            watch(client.fd, EPOLLIN, EPOLL_CTL_MOD);
+        client.writing = false;
+    }
+
+    void sendFrame(size_t slot)
+    {
+        frame_.str(string());
+        frame_ << "\x1B[2J\x1B[H";
+
+        world_.getPlayer(slot)->drawStatus(frame_);
+        world_.drawMap(frame_, slot);
+        world_.drawMessages(frame_);
+        world_.drawWorldInformation(frame_, slot);
+        frame_ << "\tPlayers : " << clients_.size() << '\n';
+        frame_ << FRAME_COMMANDS << clients_[slot].commands << '\n' << FRAME_END;
+
+        PROFILE_COUNT(BYTES, static_cast<size_t>(frame_.tellp()));
+        clients_[slot].output += frame_.str();
+        flushClient(slot);
+    }
+
+    string_view takeLine(Client& client)
+    {
+        size_t lineEnd = client.input.find('\n');
+        string_view line(client.input.data(), lineEnd);
+        if(!line.empty() && line.back() == '\r')
+            line.remove_suffix(1);
+        return line;
+    }
+
+    void dropLine(Client& client)
+    {
+        client.input.erase(0, client.input.find('\n') + 1);
+        if(--client.lines == 0)
+            waiting_--;
+    }
+
+    void runRound()
+    {
+        auto start = chrono::steady_clock::now();
+
+        world_.resetWorldMap();
+        for(auto& player : world_.getPlayers())
+            player->checkCollisions(world_);
+        world_.EnemiesTurn();
+
+        world_.clearPlayerAttacks();
+        for(size_t slot = 0; slot < clients_.size(); slot++)
+        {
+            Client& client = clients_[slot];
+            if(client.lines == 0 || client.closing)
+                continue;
+
+            if(!parser_.parsePlayerCommand(takeLine(client), world_, slot))
+                client.closing = true;
+            dropLine(client);
+            client.commands++;
+            commands_++;
+        }
+        world_.drawPlayerActions();
+
+        for(size_t slot = 0; slot < clients_.size(); slot++)
+            sendFrame(slot);
+        PROFILE_END_TURN();
+
+        rounds_++;
+        roundTimes_.push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - start).count());
+    }
+
+    void dropClosedClients()
+    {
+        for(size_t slot = clients_.size(); slot-- > 0;)
+        {
+            if(clients_[slot].closing)
+                disconnect(slot);
+        }
+    }
+
+public:
+
+    GameServer(World& world, const ServerOptions& options)
+        : world_(world), options_(options), gen_(options.seed) {}
+
+    ~GameServer()
+    {
+        for(auto& client : clients_)
+            close(client.fd);
+        if(epollFd_ >= 0)
+            close(epollFd_);
+        if(listenFd_ >= 0)
+            close(listenFd_);
+        if(!address_.unixPath.empty())
+            unlink(address_.unixPath.c_str());
+    }
+
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    bool open()
+    {
+        if(!parseSocketAddress(options_.address, address_))
+        {
+            cerr << "Bad address " << options_.address << ", expected unix:PATH or tcp:PORT" << endl;
+            return false;
+        }
+
+        listenFd_ = socket(address_.storage.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if(listenFd_ < 0)
+        {
+            cerr << "Could not create a socket : " << strerror(errno) << endl;
+            return false;
+        }
+
+        int on = 1;
+        setsockopt(listenFd_, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if(!address_.unixPath.empty())
+            unlink(address_.unixPath.c_str());
+
+        if(bind(listenFd_, reinterpret_cast<sockaddr*>(&address_.storage), address_.length) < 0
+                || listen(listenFd_, SOMAXCONN) < 0)
+        {
+            cerr << "Could not listen on " << options_.address << " : " << strerror(errno) << endl;
+            return false;
+        }
+
+        epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+        if(epollFd_ < 0)
+        {
+            cerr << "Could not create epoll : " << strerror(errno) << endl;
+            return false;
+        }
+        watch(listenFd_, EPOLLIN, EPOLL_CTL_ADD);
+
+        // The world's own player only marks where clients spawn.
+        spawn_ = world_.getPlayer(0)->getPosition();
+        while(!world_.getPlayers().empty())
+            world_.removePlayer(0);
+
+        parser_.setFileCommands(false);
+        world_.setShouldDrawEntities(true);
+        return true;
+    }
+
+    void run()
+    {
+        constexpr int MAX_EVENTS = 256;
+        epoll_event events[MAX_EVENTS];
+        auto deadline = chrono::steady_clock::time_point::max();
+
+        cout << "Serving on " << options_.address << endl;
+
+        while(!serverStopRequested && (options_.rounds == 0 || rounds_ < options_.rounds))
+        {
+            int timeout = -1;
+            if(waiting_ > 0)
+            {
+                auto left = chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now());
+                timeout = static_cast<int>(max<chrono::milliseconds::rep>(0, left.count()));
+            }
+
+            int ready = epoll_wait(epollFd_, events, MAX_EVENTS, timeout);
+            if(ready < 0 && errno != EINTR)
+            {
+                cerr << "epoll_wait failed : " << strerror(errno) << endl;
+                break;
+            }
+
+            bool hadWaiting = waiting_ > 0;
+            for(int i = 0; i < ready; i++)
+            {
+                int fd = events[i].data.fd;
+                if(fd == listenFd_)
+                {
+                    acceptClients();
+                    continue;
+                }
+
+                int32_t slot = fd < static_cast<int>(slotOfFd_.size()) ? slotOfFd_[fd] : -1;
+                if(slot < 0)
+                    continue;
+                if(events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+                    readClient(slot);
+                if(events[i].events & EPOLLOUT)
+                    flushClient(slot);
+            }
+            dropClosedClients();
+
+            // The tick starts with the first command of the round.
+            if(!hadWaiting && waiting_ > 0)
+                deadline = chrono::steady_clock::now() + chrono::milliseconds(options_.tickMs);
+
+            if(waiting_ > 0 && (waiting_ == clients_.size() || chrono::steady_clock::now() >= deadline))
+            {
+                runRound();
+                dropClosedClients();
+                deadline = chrono::steady_clock::now() + chrono::milliseconds(options_.tickMs);
+            }
+        }
+    }
+
+    void printStats() const
+    {
+        vector<double> times = roundTimes_;
+        sort(times.begin(), times.end());
+        auto percentile = [&](double p) {
+            return times.empty() ? 0.0 : times[static_cast<size_t>(p * (times.size() - 1))];
+        };
+
+        cout << "rounds        : " << rounds_ << endl;
+        cout << "commands      : " << commands_ << endl;
+        cout << "peak clients  : " << peakClients_ << endl;
+        cout << "p50 round     : " << percentile(0.50) << " us" << endl;
+        cout << "p99 round     : " << percentile(0.99) << " us" << endl;
+    }
+};
+
+bool runServer(const HeadlessOptions& setup, const ServerOptions& options,
+        limits viewport, ThreadPool& pool)
+{
+    auto worldPointer = createWorld(setup.levelPath, setup.worldLimits,
+            options.seed, setup.enemies, setup.hounds, setup.swoopers, setup.guards);
+    if(!worldPointer)
+        return false;
+    worldPointer->setViewport(viewport);
+    worldPointer->setThreadPool(&pool);
+    worldPointer->setFog(setup.fog);
+
+    bool eventsOk;
+    auto events = openEventLog(setup, eventsOk);
+    if(!eventsOk)
+        return false;
+    worldPointer->setEventLog(events.get());
+
+    GameServer server(*worldPointer, options);
+    if(!server.open())
+        return false;
+
+    struct sigaction action{};
+    action.sa_handler = requestServerStop;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    server.run();
+    server.printStats();
+    worldPointer->setEventLog(nullptr);
+    return closeEventLog(events.get());
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <sys/socket.h>
+
+#include "headless.h"
+
+// Local multi client server. Every connection gets its own player in
+// the shared world and is sent only the viewport around it.
+// Addresses are "unix:PATH" or "tcp:PORT", tcp only listens on loopback.
+// A round runs once every client has a command waiting, or when the
+// tick runs out with at least one waiting. Frames end with FRAME_END,
+// the line before it counts the commands taken from that client.
+constexpr char FRAME_END = '\f';
+constexpr string_view FRAME_COMMANDS = "\tCommands : ";
+
+struct ServerOptions
+{
+    string address;
+    long rounds = 0;    // 0 keeps going until interrupted
+    int tickMs = 50;
+    unsigned seed = 1;
+};
+
+struct SocketAddress
+{
+    sockaddr_storage storage{};
+    socklen_t length = 0;
+    string unixPath;
+};
+
+bool parseSocketAddress(const string& text, SocketAddress& result);
+
+// Small frames go out as soon as they're written.
+void setNoDelay(int fd, const SocketAddress& address);
+
+bool runServer(const HeadlessOptions& setup, const ServerOptions& options,
+        limits viewport, ThreadPool& pool);
@@ -0,0 +1,201 @@
+#include "setup.h"
+
+void scatterEnemies(World& world, int count, unsigned seed)
+{
+    mt19937 gen(seed);
+    limits worldLimits = world.getWorldLimits();
+    size_t first = world.getEnemies(ENEMY_TYPE::BLIND_BAT).size() + 1;
+    for(int i = 0; i < count; i++)
+    {
+        world.spawnEnemy<BlindBatArchetype>(position(gen() % worldLimits.first,
+                    gen() % worldLimits.second), string(BlindBatArchetype::name) + " " + to_string(first + i));
+    }
+}
+
+void scatterHounds(World& world, int count, unsigned seed)
+{
+    mt19937 gen(seed ^ 0x484f554e);
+    limits worldLimits = world.getWorldLimits();
+    for(int i = 0; i < count; i++)
+    {
+        position pos;
+        int attempts = 0;
+        do
+        {
+            pos = position(gen() % worldLimits.first, gen() % worldLimits.second);
+        } while(!world.isPassable(pos) && ++attempts < 64);
+
+        world.spawnEnemy<HoundArchetype>(pos, string(HoundArchetype::name) + " " + to_string(i + 1));
+    }
+}
+
+constexpr int SWOOP_SIGHT  = 6;
+constexpr int SWOOP_TURNS  = 8;
+constexpr int SWOOP_REST   = 5;
+constexpr int HUNT_TURNS   = 12;
+constexpr int RETURN_TURNS = 32;
+
+// Phases of the scripts below, what each does when it's next run.
+enum ScriptPhase : int32_t
+{
+    WATCHING,
+    CHASING,
+    RETURNING,
+    RESTING,
+};
+
+// Perches at home until someone comes close, swoops at them for a
+// few turns or until badly hurt, then flies back and rests before
+// perching again.
+Behaviour swoopingBat(Actor self)
+{
+    BehaviourState& state = self.getState();
+    for(;;)
+    {
+        switch(state.phase)
+        {
+            case WATCHING:
+                state.phase = CHASING;
+                state.turns = 0;
+                co_await self.untilPlayerWithin(SWOOP_SIGHT);
+                break;
+
+            case CHASING:
+            {
+                Player* prey = self.findPlayer(SWOOP_SIGHT);
+                if(state.turns++ == SWOOP_TURNS || self.getHealth() <= BlindBatArchetype::health / 3 || !prey)
+                {
+                    state.phase = RETURNING;
+                    state.turns = 0;
+                    break;
+                }
+                if(!self.attack())
+                    self.stepTowards(prey->getPosition());
+                co_await self.nextTurn();
+                break;
+            }
+
+            case RETURNING:
+                if(state.turns++ == RETURN_TURNS || self.getPosition() == self.getHome())
+                {
+                    state.phase = RESTING;
+                    break;
+                }
+                self.stepTowards(self.getHome());
+                co_await self.nextTurn();
+                break;
+
+            default:
+                state.phase = WATCHING;
+                co_await self.wait(SWOOP_REST);
+                break;
+        }
+    }
+}
+
+// Sleeps at its post until something hurts it, hunts players down
+// for a while, then goes back to sleep.
+Behaviour guardingHound(Actor self)
+{
+    BehaviourState& state = self.getState();
+    for(;;)
+    {
+        switch(state.phase)
+        {
+            case WATCHING:
+                state.phase = CHASING;
+                state.turns = 0;
+                co_await self.untilHurt();
+                break;
+
+            case CHASING:
+                if(state.turns++ == HUNT_TURNS)
+                {
+                    state.phase = RETURNING;
+                    state.turns = 0;
+                    break;
+                }
+                if(!self.attack())
+                    self.followPlayers();
+                co_await self.nextTurn();
+                break;
+
+            default:
+                if(state.turns++ == RETURN_TURNS || self.getPosition() == self.getHome())
+                {
+                    state.phase = WATCHING;
+                    break;
+                }
+                self.stepTowards(self.getHome());
+                co_await self.nextTurn();
+                break;
+        }
+    }
+}
+
+const bool scriptsRegistered = BehaviourScripts::add("swooping bat", swoopingBat)
+    && BehaviourScripts::add("guarding hound", guardingHound);
+
+// Enemies of Archetype on open ground, each handed to script.
+template<class Archetype>
+void scatterScripted(World& world, int count, unsigned seed, Behaviour (*script)(Actor),
+        const string& name)
+{
+    mt19937 gen(seed ^ 0x53435250);
+    limits worldLimits = world.getWorldLimits();
+    for(int i = 0; i < count; i++)
+    {
+        position pos;
+        int attempts = 0;
+        do
+        {
+            pos = position(gen() % worldLimits.first, gen() % worldLimits.second);
+        } while(!world.isPassable(pos) && ++attempts < 64);
+
+        EntityId id = world.spawnEnemy<Archetype>(pos, name + " " + to_string(i + 1));
+        world.runBehaviour(id, script);
+    }
+}
+
+void spawnDefaultEntities(World& world)
+{
+    Player player1("John", 200, 20, 30,  position(4, 23), 'J');
+    world.addEntity(player1);
+
+    world.spawnEnemy<BlindBatArchetype>(position(5, 9), "Blind Bat 1");
+    world.spawnEnemy<BlindBatArchetype>(position(5, 34), "Blind Bat 2");
+    world.spawnEnemy<BlindBatArchetype>(position(5, 59), "Blind Bat 3");
+}
+
+unique_ptr<World> createWorld(const string& levelPath, limits worldLimits,
+        unsigned seed, int extraEnemies, int extraHounds, int swoopers, int guards)
+{
+    unique_ptr<World> world;
+
+    if(!levelPath.empty())
+    {
+        auto level = LevelFile::open(levelPath);
+        if(!level)
+            return nullptr;
+
+        world = make_unique<World>(level, seed);
+        world->spawnLevelEntities();
+    }
+    else
+    {
+        world = make_unique<World>(worldLimits, seed);
+        spawnDefaultEntities(*world);
+    }
+
+    scatterEnemies(*world, extraEnemies, seed);
+    scatterHounds(*world, extraHounds, seed);
+    scatterScripted<BlindBatArchetype>(*world, swoopers, seed, swoopingBat, "Swooping Bat");
+    scatterScripted<HoundArchetype>(*world, guards, seed ^ 0x4755, guardingHound, "Guard Hound");
+
+    if(world->getPlayers().empty())
+    {
+        cerr << "The world has no player in it" << endl;
+        return nullptr;
+    }
+    return world;
+}
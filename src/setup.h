@@ -0,0 +1,17 @@
+#pragma once
+
+#include "world.h"
+
+// Scatters extra bats at random spots around the map.
+void scatterEnemies(World& world, int count, unsigned seed);
+
+// Hounds are only put on open ground, they'd be stuck in a wall.
+void scatterHounds(World& world, int count, unsigned seed);
+
+// Adds the starting player and bats.
+void spawnDefaultEntities(World& world);
+
+// Builds the world from a level file when one is given, otherwise
+// the built in scene, and fills it with its starting entities.
+unique_ptr<World> createWorld(const string& levelPath, limits worldLimits,
+        unsigned seed, int extraEnemies, int extraHounds, int swoopers, int guards);
@@ -0,0 +1,430 @@
+#pragma once
+
+#include <unistd.h>
+
+#include "common.h"
+
+// 64 bit FNV-1a applied to whole 8 byte words, bytes are fed in
+// any chunking and the result only depends on the byte sequence.
+class Checksum
+{
+
+private:
+
+    static constexpr uint64_t OFFSET = 14695981039346656037ull;
+    static constexpr uint64_t PRIME  = 1099511628211ull;
+
+    uint64_t hash_ = OFFSET;
+    uint64_t pending_ = 0;
+    size_t pendingBytes_ = 0;
+
+    void mix(uint64_t word)
+    {
+        hash_ = (hash_ ^ word) * PRIME;
+    }
+
+public:
+
+    void update(const void* data, size_t size)
+    {
+        auto bytes = static_cast<const unsigned char*>(data);
+
+        while(size > 0 && pendingBytes_ != 0)
+        {
+            pending_ |= static_cast<uint64_t>(*bytes++) << (8 * pendingBytes_++);
+            size--;
+            if(pendingBytes_ == 8)
+            {
+                mix(pending_);
+                pending_ = 0;
+                pendingBytes_ = 0;
+            }
+        }
+
+        while(size >= 8)
+        {
+            uint64_t word;
+            memcpy(&word, bytes, 8);
+            mix(word);
+            bytes += 8;
+            size  -= 8;
+        }
+
+        while(size-- > 0)
+            pending_ |= static_cast<uint64_t>(*bytes++) << (8 * pendingBytes_++);
+    }
+
+    uint64_t finish() const
+    {
+        uint64_t hash = hash_;
+        if(pendingBytes_)
+            hash = (hash ^ pending_ ^ (static_cast<uint64_t>(pendingBytes_) << 56)) * PRIME;
+        return hash;
+    }
+};
+
+struct SnapshotHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t payloadSize;
+    uint64_t checksum;
+};
+
+constexpr char SNAPSHOT_MAGIC[8] = { 'T', 'T', 'R', 'P', 'G', 'S', 'A', 'V' };
+constexpr uint32_t SNAPSHOT_VERSION = 7;
+
+// A snapshot payload kept in memory, cut into pages. The writer
+// splits the state into parts, each with a version that changes
+// whenever that part of the state does. A part whose version is the
+// same as in the snapshot before isn't written at all, its pages are
+// shared as they are. Within a part that was written, a page that
+// comes out the same as the one in its place the snapshot before is
+// shared with it, so keeping a snapshot every turn costs about what
+// changed during the turn, in time as well as memory.
+class PagedSnapshot
+{
+
+public:
+
+    static constexpr size_t PAGE_SIZE = 4096;
+    using Page = shared_ptr<const vector<char>>;
+
+    // The writer starts a section at every array and a few other
+    // places, so something growing only moves the pages of its own
+    // section and the ones after still line up with the last turn's.
+    using Sections = vector< vector<Page> >;
+
+    struct Part
+    {
+        // 0 for parts written every time.
+        uint64_t version = 0;
+        size_t size = 0;
+        shared_ptr<const Sections> sections;
+    };
+
+private:
+
+    vector<Part> parts_;
+    size_t size_ = 0;
+
+    friend class SnapshotPager;
+
+public:
+
+    template<class Function>
+    void forEachPart(Function function) const
+    {
+        for(auto& part : parts_)
+            function(part);
+    }
+
+    template<class Function>
+    void forEachPage(Function function) const
+    {
+        for(auto& part : parts_)
+        {
+            for(auto& section : *part.sections)
+            {
+                for(auto& page : section)
+                    function(page);
+            }
+        }
+    }
+
+    // The payload in one piece again, for a SnapshotReader.
+    void copyTo(vector<char>& payload) const
+    {
+        payload.clear();
+        payload.reserve(size_);
+        forEachPage([&payload](const Page& page) {
+            payload.insert(payload.end(), page->begin(), page->end());
+        });
+    }
+};
+
+// Cuts what a SnapshotWriter writes into the pages of a new
+// PagedSnapshot, sharing whatever it can with the previous one.
+class SnapshotPager
+{
+
+private:
+
+    const PagedSnapshot* previous_;
+    PagedSnapshot snapshot_;
+
+    // The part being written.
+    PagedSnapshot::Sections sections_;
+    uint64_t version_ = 0;
+    size_t partSize_ = 0;
+    // Set when the part was taken whole from previous_.
+    bool reused_ = false;
+
+    // Most writes are a few bytes, they're gathered here first.
+    array<char, PagedSnapshot::PAGE_SIZE> pending_;
+    size_t pendingSize_ = 0;
+
+    // The previous snapshot's part in the place of the one being
+    // written, or null.
+    const PagedSnapshot::Part* previousPart() const
+    {
+        size_t index = snapshot_.parts_.size();
+        return previous_ && index < previous_->parts_.size() ? &previous_->parts_[index] : nullptr;
+    }
+
+    void flush()
+    {
+        if(pendingSize_ == 0)
+            return;
+
+        size_t section = sections_.size() - 1;
+        auto& pages = sections_.back();
+        const PagedSnapshot::Page* old = nullptr;
+        const PagedSnapshot::Part* oldPart = previousPart();
+        if(oldPart && section < oldPart->sections->size()
+                && pages.size() < (*oldPart->sections)[section].size())
+            old = &(*oldPart->sections)[section][pages.size()];
+
+        if(old && (*old)->size() == pendingSize_ && memcmp((*old)->data(), pending_.data(), pendingSize_) == 0)
+            pages.push_back(*old);
+        else
+            pages.push_back(make_shared<const vector<char>>(pending_.data(), pending_.data() + pendingSize_));
+        partSize_ += pendingSize_;
+        pendingSize_ = 0;
+    }
+
+    void endPart()
+    {
+        if(reused_)
+        {
+            reused_ = false;
+            return;
+        }
+        flush();
+        snapshot_.parts_.push_back({ version_, partSize_,
+                make_shared<const PagedSnapshot::Sections>(move(sections_)) });
+        snapshot_.size_ += partSize_;
+        sections_.clear();
+        partSize_ = 0;
+    }
+
+public:
+
+    explicit SnapshotPager(const PagedSnapshot* previous) : previous_(previous)
+    {
+        sections_.emplace_back();
+    }
+
+    void write(const char* data, size_t size)
+    {
+        if(size < PagedSnapshot::PAGE_SIZE - pendingSize_)
+        {
+            memcpy(pending_.data() + pendingSize_, data, size);
+            pendingSize_ += size;
+            return;
+        }
+        while(size > 0)
+        {
+            size_t take = min(size, PagedSnapshot::PAGE_SIZE - pendingSize_);
+            memcpy(pending_.data() + pendingSize_, data, take);
+            pendingSize_ += take;
+            data += take;
+            size -= take;
+            if(pendingSize_ == PagedSnapshot::PAGE_SIZE)
+                flush();
+        }
+    }
+
+    // Always starts one, even after an empty section, so sections
+    // keep their numbers from one turn to the next.
+    void section()
+    {
+        flush();
+        sections_.emplace_back();
+    }
+
+    // Starts the next part. True when the previous snapshot's part
+    // in its place has the same version and was taken instead,
+    // nothing is to be written until the next part then.
+    bool part(uint64_t version)
+    {
+        endPart();
+        version_ = version;
+        sections_.emplace_back();
+
+        const PagedSnapshot::Part* old = previousPart();
+        if(version == 0 || !old || old->version != version)
+            return false;
+
+        snapshot_.parts_.push_back(*old);
+        snapshot_.size_ += old->size;
+        sections_.clear();
+        reused_ = true;
+        return true;
+    }
+
+    PagedSnapshot finish()
+    {
+        endPart();
+        return move(snapshot_);
+    }
+};
+
+// Streams raw values and whole arrays to a file or into pages while
+// checksumming them. Without either it only hashes, which is how the
+// world's state hash is computed.
+class SnapshotWriter
+{
+
+private:
+
+    ofstream* out_ = nullptr;
+    SnapshotPager* pages_ = nullptr;
+    Checksum checksum_;
+    uint64_t size_ = 0;
+
+public:
+
+    explicit SnapshotWriter(ofstream* out = nullptr) : out_(out) {}
+
+    explicit SnapshotWriter(SnapshotPager* pages) : pages_(pages) {}
+
+    void bytes(const void* data, size_t size)
+    {
+        if(size == 0)
+            return;
+        size_ += size;
+        // Pages stay in memory, nothing to check them against.
+        if(pages_)
+        {
+            pages_->write(static_cast<const char*>(data), size);
+            return;
+        }
+        checksum_.update(data, size);
+        if(out_)
+            out_->write(static_cast<const char*>(data), size);
+    }
+
+    // Where pages should line up from one snapshot to the next, only
+    // matters when writing pages.
+    void section()
+    {
+        if(pages_)
+            pages_->section();
+    }
+
+    // Starts a part of the state that has only changed if version
+    // has, see PagedSnapshot. True when the part was kept from the
+    // last snapshot and mustn't be written, only ever when writing
+    // pages.
+    bool part(uint64_t version)
+    {
+        return pages_ && pages_->part(version);
+    }
+
+    template<class T>
+    void value(const T& data)
+    {
+        static_assert(is_trivially_copy_constructible<T>::value, "only plain values can be written");
+        bytes(&data, sizeof(T));
+    }
+
+    template<class T>
+    void array(const vector<T>& data)
+    {
+        static_assert(is_trivially_copy_constructible<T>::value, "only plain values can be written");
+        section();
+        value<uint64_t>(data.size());
+        bytes(data.data(), data.size() * sizeof(T));
+    }
+
+    void text(string_view data)
+    {
+        value<uint32_t>(static_cast<uint32_t>(data.size()));
+        bytes(data.data(), data.size());
+    }
+
+    uint64_t getChecksum() const { return checksum_.finish(); }
+    uint64_t getSize() const { return size_; }
+    bool isHashOnly() const { return out_ == nullptr && pages_ == nullptr; }
+};
+
+// Reads back what SnapshotWriter wrote from a buffer holding the
+// whole payload. Every read is bounds checked, once one fails
+// all the following ones fail too.
+class SnapshotReader
+{
+
+private:
+
+    const char* data_;
+    size_t size_;
+    size_t offset_ = 0;
+    bool ok_ = true;
+
+    bool take(size_t size)
+    {
+        if(!ok_ || size > size_ - offset_)
+        {
+            ok_ = false;
+            return false;
+        }
+        return true;
+    }
+
+public:
+
+    SnapshotReader(const char* data, size_t size) : data_(data), size_(size) {}
+
+    bool ok() const { return ok_; }
+    bool atEnd() const { return offset_ == size_; }
+
+    void bytes(void* data, size_t size)
+    {
+        if(size == 0 || !take(size))
+            return;
+        memcpy(data, data_ + offset_, size);
+        offset_ += size;
+    }
+
+    template<class T>
+    T value()
+    {
+        T data{};
+        bytes(&data, sizeof(T));
+        return data;
+    }
+
+    template<class T>
+    void array(vector<T>& data)
+    {
+        uint64_t count = value<uint64_t>();
+        if(!ok_ || count > (size_ - offset_) / sizeof(T))
+        {
+            ok_ = false;
+            return;
+        }
+        data.resize(count);
+        bytes(data.data(), count * sizeof(T));
+    }
+
+    string text()
+    {
+        uint32_t size = value<uint32_t>();
+        if(!take(size))
+            return string();
+        string data(data_ + offset_, size);
+        offset_ += size;
+        return data;
+    }
+
+    const char* view(size_t size)
+    {
+        if(!take(size))
+            return nullptr;
+        const char* data = data_ + offset_;
+        offset_ += size;
+        return data;
+    }
+};
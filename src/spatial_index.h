@@ -0,0 +1,260 @@
+#pragma once
+
+#include "entity.h"
+
+// Maps a world cell to the slots of the entities standing on it, so hit
+// tests and collision checks only look at one cell instead of every enemy.
+// Each cell holds the head of an intrusive list threaded through the
+// entity slots, moving an entity never allocates. Heads live in small
+// blocks created the first time something walks into them, so the
+// index doesn't grow with the size of the world.
+class SpatialIndex
+{
+
+public:
+
+    static constexpr int32_t NONE = -1;
+
+    class Iterator
+    {
+
+    private:
+
+        const vector<int32_t>* next_;
+        int32_t current_;
+
+    public:
+
+        Iterator(const vector<int32_t>* next, int32_t current)
+            : next_(next), current_(current) {}
+
+        uint32_t operator*() const { return static_cast<uint32_t>(current_); }
+
+        Iterator& operator++()
+        {
+            current_ = (*next_)[current_];
+            return *this;
+        }
+
+        bool operator!=(const Iterator& other) const { return current_ != other.current_; }
+    };
+
+    // The entities standing on one cell.
+    class Cell
+    {
+
+    private:
+
+        const vector<int32_t>* next_;
+        int32_t head_;
+
+    public:
+
+        Cell(const vector<int32_t>* next, int32_t head) : next_(next), head_(head) {}
+
+        Iterator begin() const { return Iterator(next_, head_); }
+        Iterator end() const { return Iterator(next_, NONE); }
+        bool empty() const { return head_ == NONE; }
+        uint32_t front() const { return static_cast<uint32_t>(head_); }
+    };
+
+private:
+
+    static constexpr int BLOCK_SHIFT = 3;
+    static constexpr int BLOCK_SIZE  = 1 << BLOCK_SHIFT;
+    static constexpr int BLOCK_MASK  = BLOCK_SIZE - 1;
+
+    static constexpr size_t PREALLOCATE_CELLS = 1 << 20;
+
+    using Block = array<int32_t, BLOCK_SIZE * BLOCK_SIZE>;
+
+    limits limits_ {0, 0};
+    unordered_map<uint64_t, Block> blocks_;
+    vector<int32_t> next_;
+    vector<int32_t> prev_;
+
+    // The head slot of the cell each entity is on. Blocks are
+    // map nodes, so these stay valid when the map rehashes.
+    vector<int32_t*> cellOf_;
+
+    bool inside(position pos) const
+    {
+        return pos.first >= 0 && pos.first < limits_.first
+            && pos.second >= 0 && pos.second < limits_.second;
+    }
+
+    static uint64_t blockKey(int blockRow, int blockColumn)
+    {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(blockRow)) << 32)
+            | static_cast<uint32_t>(blockColumn);
+    }
+
+    static size_t cellInBlock(position pos)
+    {
+        return (pos.first & BLOCK_MASK) * BLOCK_SIZE + (pos.second & BLOCK_MASK);
+    }
+
+    int32_t& head(position pos)
+    {
+        auto key = blockKey(pos.first >> BLOCK_SHIFT, pos.second >> BLOCK_SHIFT);
+        auto block = blocks_.find(key);
+        if(block == blocks_.end())
+        {
+            block = blocks_.emplace(key, Block{}).first;
+            block->second.fill(NONE);
+        }
+        return block->second[cellInBlock(pos)];
+    }
+
+    int32_t headAt(position pos) const
+    {
+        auto block = blocks_.find(blockKey(pos.first >> BLOCK_SHIFT, pos.second >> BLOCK_SHIFT));
+        if(block == blocks_.end())
+            return NONE;
+        return block->second[cellInBlock(pos)];
+    }
+
+public:
+
+    void reset(limits worldLimits)
+    {
+        limits_ = worldLimits;
+        blocks_.clear();
+        next_.clear();
+        prev_.clear();
+        cellOf_.clear();
+
+        // Small worlds get every block up front so walking
+        // into a new part of the map never allocates.
+        if(static_cast<size_t>(worldLimits.first) * worldLimits.second <= PREALLOCATE_CELLS)
+        {
+            for(int row = 0; row < worldLimits.first; row += BLOCK_SIZE)
+                for(int column = 0; column < worldLimits.second; column += BLOCK_SIZE)
+                    head(position(row, column));
+        }
+    }
+
+    void link(uint32_t entity, int32_t* first)
+    {
+        next_[entity] = *first;
+        prev_[entity] = NONE;
+        if(*first != NONE)
+            prev_[*first] = entity;
+        *first = entity;
+        cellOf_[entity] = first;
+    }
+
+    void unlink(uint32_t entity)
+    {
+        if(prev_[entity] != NONE)
+            next_[prev_[entity]] = next_[entity];
+        else
+            *cellOf_[entity] = next_[entity];
+
+        if(next_[entity] != NONE)
+            prev_[next_[entity]] = prev_[entity];
+
+        cellOf_[entity] = nullptr;
+    }
+
+    void insert(uint32_t entity, position pos)
+    {
+        if(!inside(pos))
+            return;
+
+        if(entity >= next_.size())
+        {
+            next_.resize(entity + 1, NONE);
+            prev_.resize(entity + 1, NONE);
+            cellOf_.resize(entity + 1, nullptr);
+        }
+
+        link(entity, &head(pos));
+    }
+
+    void erase(uint32_t entity)
+    {
+        if(entity < cellOf_.size() && cellOf_[entity])
+            unlink(entity);
+    }
+
+    // Moves inside one block don't need a lookup at all,
+    // the block is found from the cell the entity is on.
+    void move(uint32_t entity, position from, position to)
+    {
+        if(from == to)
+            return;
+
+        bool sameBlock = (from.first >> BLOCK_SHIFT) == (to.first >> BLOCK_SHIFT)
+            && (from.second >> BLOCK_SHIFT) == (to.second >> BLOCK_SHIFT);
+
+        if(sameBlock && inside(to) && cellOf_[entity])
+        {
+            int32_t* blockBegin = cellOf_[entity] - cellInBlock(from);
+            unlink(entity);
+            link(entity, blockBegin + cellInBlock(to));
+            return;
+        }
+
+        erase(entity);
+        insert(entity, to);
+    }
+
+    // Used when the store moves an entity to another slot.
+    void rename(uint32_t from, uint32_t to)
+    {
+        int32_t* cell = cellOf_[from];
+        if(!cell)
+            return;
+        unlink(from);
+        link(to, cell);
+    }
+
+    Cell at(position pos) const
+    {
+        if(!inside(pos))
+            return Cell(&next_, NONE);
+        return Cell(&next_, headAt(pos));
+    }
+
+    // Calls visit(entity, position) for everything inside the rectangle,
+    // one block lookup per block instead of one per cell. Stops early
+    // when visit returns false.
+    template<class Visitor>
+    void forEachInRect(position origin, limits size, Visitor visit) const
+    {
+        int rowBegin    = max(origin.first, 0);
+        int columnBegin = max(origin.second, 0);
+        int rowEnd      = min(origin.first + size.first, limits_.first);
+        int columnEnd   = min(origin.second + size.second, limits_.second);
+
+        for(int blockRow = rowBegin >> BLOCK_SHIFT; (blockRow << BLOCK_SHIFT) < rowEnd; blockRow++)
+        {
+            for(int blockColumn = columnBegin >> BLOCK_SHIFT; (blockColumn << BLOCK_SHIFT) < columnEnd; blockColumn++)
+            {
+                auto block = blocks_.find(blockKey(blockRow, blockColumn));
+                if(block == blocks_.end())
+                    continue;
+
+                int firstRow    = max(rowBegin, blockRow << BLOCK_SHIFT);
+                int lastRow     = min(rowEnd, (blockRow + 1) << BLOCK_SHIFT);
+                int firstColumn = max(columnBegin, blockColumn << BLOCK_SHIFT);
+                int lastColumn  = min(columnEnd, (blockColumn + 1) << BLOCK_SHIFT);
+
+                for(int row = firstRow; row < lastRow; row++)
+                {
+                    for(int column = firstColumn; column < lastColumn; column++)
+                    {
+                        position pos(row, column);
+                        for(int32_t entity = block->second[cellInBlock(pos)]; entity != NONE; entity = next_[entity])
+                        {
+                            if(!visit(static_cast<uint32_t>(entity), pos))
+                                return;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+};
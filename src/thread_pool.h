@@ -0,0 +1,117 @@
+#pragma once
+
+#include "common.h"
+
+// Fixed set of workers that split index ranges between them. The
+// calling thread takes ranges too and parallelFor only returns once
+// every range is done. Nothing is allocated per call.
+class ThreadPool
+{
+
+private:
+
+    using Task = void (*)(void* context, size_t begin, size_t end);
+
+    vector<thread> workers_;
+    mutex mutex_;
+    condition_variable wake_;
+    condition_variable done_;
+
+    Task task_ = nullptr;
+    void* context_ = nullptr;
+    size_t count_ = 0;
+    size_t grain_ = 1;
+    atomic<size_t> next_ {0};
+
+    uint64_t generation_ = 0;
+    size_t busy_ = 0;
+    bool stopping_ = false;
+
+    void runRanges()
+    {
+        for(;;)
+        {
+            size_t begin = next_.fetch_add(grain_, memory_order_relaxed);
+            if(begin >= count_)
+                return;
+            task_(context_, begin, min(begin + grain_, count_));
+        }
+    }
+
+    void workerLoop()
+    {
+        uint64_t seen = 0;
+        for(;;)
+        {
+            {
+                unique_lock<mutex> lock(mutex_);
+                wake_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+                if(stopping_)
+                    return;
+                seen = generation_;
+            }
+
+            runRanges();
+
+            lock_guard<mutex> lock(mutex_);
+            if(--busy_ == 0)
+                done_.notify_one();
+        }
+    }
+
+public:
+
+    // threads counts the caller, so 1 means no extra threads.
+    explicit ThreadPool(size_t threads)
+    {
+        for(size_t i = 1; i < threads; i++)
+            workers_.emplace_back(&ThreadPool::workerLoop, this);
+    }
+
+    ~ThreadPool()
+    {
+        {
+            lock_guard<mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for(auto& worker : workers_)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t getThreadCount() const { return workers_.size() + 1; }
+
+    // Calls body(begin, end) over [0, count) in ranges of grain.
+    template<class Body>
+    void parallelFor(size_t count, size_t grain, Body& body)
+    {
+        if(workers_.empty() || count <= grain)
+        {
+            if(count > 0)
+                body(size_t(0), count);
+            return;
+        }
+
+        {
+            lock_guard<mutex> lock(mutex_);
+            task_ = [](void* context, size_t begin, size_t end) {
+                (*static_cast<Body*>(context))(begin, end);
+            };
+            context_ = &body;
+            count_   = count;
+            grain_   = grain;
+            next_.store(0, memory_order_relaxed);
+            busy_    = workers_.size();
+            generation_++;
+        }
+        wake_.notify_all();
+
+        runRanges();
+
+        unique_lock<mutex> lock(mutex_);
+        done_.wait(lock, [&] { return busy_ == 0; });
+    }
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "snapshot.h"
+
+// Snapshots of the last turns, oldest first, kept for undo.
+class TurnHistory
+{
+
+public:
+
+    struct Turn
+    {
+        PagedSnapshot snapshot;
+    };
+
+private:
+
+    deque<Turn> turns_;
+    size_t depth_ = 0;
+
+public:
+
+    // 0 keeps nothing.
+    void setDepth(size_t turns)
+    {
+        depth_ = turns;
+        while(turns_.size() > depth_)
+            turns_.pop_front();
+    }
+
+    bool isEnabled() const { return depth_ > 0; }
+    size_t size() const { return turns_.size(); }
+
+    const PagedSnapshot* newest() const
+    {
+        return turns_.empty() ? nullptr : &turns_.back().snapshot;
+    }
+
+    void push(PagedSnapshot snapshot)
+    {
+        turns_.push_back({ move(snapshot) });
+        if(turns_.size() > depth_)
+            turns_.pop_front();
+    }
+
+    // 0 is the newest.
+    const Turn& get(size_t back) const
+    {
+        return turns_[turns_.size() - 1 - back];
+    }
+
+    void dropNewest(size_t count)
+    {
+        turns_.resize(turns_.size() - min(count, turns_.size()));
+    }
+
+    // What all of it takes, counting a shared part or page once.
+    size_t getBytes() const
+    {
+        vector<const PagedSnapshot::Sections*> parts;
+        size_t bytes = 0;
+        for(auto& turn : turns_)
+        {
+            turn.snapshot.forEachPart([&](const PagedSnapshot::Part& part) {
+                parts.push_back(part.sections.get());
+                bytes += sizeof(part);
+            });
+        }
+        sort(parts.begin(), parts.end());
+        parts.erase(unique(parts.begin(), parts.end()), parts.end());
+
+        vector<const vector<char>*> pages;
+        for(auto sections : parts)
+        {
+            bytes += sizeof(*sections) + sections->capacity() * sizeof(sections->front());
+            for(auto& section : *sections)
+            {
+                bytes += section.capacity() * sizeof(PagedSnapshot::Page);
+                for(auto& page : section)
+                    pages.push_back(page.get());
+            }
+        }
+        sort(pages.begin(), pages.end());
+        pages.erase(unique(pages.begin(), pages.end()), pages.end());
+        for(auto page : pages)
+            bytes += page->capacity() + sizeof(*page);
+        return bytes;
+    }
+};
@@ -0,0 +1,317 @@
+#pragma once
+
+#include "common.h"
+
+// Chase-Lev deque of tasks (Lê et al., "Correct and efficient
+// work-stealing for weak memory models"). One thread, the owner,
+// pushes at the bottom. Any thread, the owner included, takes from
+// the top with a single compare and swap, so tasks come out oldest
+// first. As nobody pops from the bottom, the fence the paper needs
+// between a pop and a steal isn't either, publishing bottom is
+// enough. The ring only grows, when full, and the rings it outgrew
+// are kept until the deque goes since a thief may still be reading
+// one. Nothing is locked and nothing is allocated once it's big
+// enough.
+template<class T>
+class TaskDeque
+{
+
+private:
+
+    static_assert(is_pointer<T>::value, "slots hold pointers, they're read and written atomically");
+
+    struct Ring
+    {
+        size_t mask;
+        unique_ptr< atomic<T>[] > slots;
+
+        explicit Ring(size_t capacity) : mask(capacity - 1), slots(new atomic<T>[capacity]) {}
+
+        size_t capacity() const { return mask + 1; }
+        T get(int64_t index) const { return slots[static_cast<size_t>(index) & mask].load(memory_order_relaxed); }
+        void put(int64_t index, T item) { slots[static_cast<size_t>(index) & mask].store(item, memory_order_relaxed); }
+    };
+
+    alignas(64) atomic<int64_t> top_ {0};
+    alignas(64) atomic<int64_t> bottom_ {0};
+    atomic<Ring*> ring_;
+    // Only touched by the owner.
+    vector< unique_ptr<Ring> > rings_;
+
+    Ring* grow(Ring* ring, int64_t top, int64_t bottom)
+    {
+        auto bigger = make_unique<Ring>(ring->capacity() * 2);
+        for(int64_t i = top; i < bottom; i++)
+            bigger->put(i, ring->get(i));
+        rings_.push_back(move(bigger));
+        ring = rings_.back().get();
+        ring_.store(ring, memory_order_release);
+        return ring;
+    }
+
+public:
+
+    // capacity is rounded up to a power of two.
+    explicit TaskDeque(size_t capacity = 256)
+    {
+        size_t rounded = 1;
+        while(rounded < capacity)
+            rounded *= 2;
+        rings_.push_back(make_unique<Ring>(rounded));
+        ring_.store(rings_.back().get(), memory_order_relaxed);
+    }
+
+    TaskDeque(const TaskDeque&) = delete;
+    TaskDeque& operator=(const TaskDeque&) = delete;
+
+    // Owner only.
+    void push(T item)
+    {
+        int64_t bottom = bottom_.load(memory_order_relaxed);
+        int64_t top = top_.load(memory_order_acquire);
+        Ring* ring = ring_.load(memory_order_relaxed);
+        if(bottom - top >= static_cast<int64_t>(ring->capacity()))
+            ring = grow(ring, top, bottom);
+        ring->put(bottom, item);
+        // Sequentially consistent for the pool, a thread about to
+        // park either sees the item or gets seen parked.
+        bottom_.store(bottom + 1, memory_order_seq_cst);
+    }
+
+    // Null when empty, or when another thread took the same task
+    // first.
+    T steal()
+    {
+        int64_t top = top_.load(memory_order_acquire);
+        int64_t bottom = bottom_.load(memory_order_acquire);
+        if(top >= bottom)
+            return nullptr;
+
+        T item = ring_.load(memory_order_acquire)->get(top);
+        if(!top_.compare_exchange_strong(top, top + 1, memory_order_seq_cst, memory_order_relaxed))
+            return nullptr;
+        return item;
+    }
+
+    bool empty() const
+    {
+        int64_t top = top_.load(memory_order_seq_cst);
+        return bottom_.load(memory_order_seq_cst) <= top;
+    }
+};
+
+// Runs tasks that may push more tasks, on a fixed set of threads
+// plus the one calling run(). Every thread owns a TaskDeque and
+// pushes there, and takes from its own deque before stealing from
+// the others'. A thread that finds nothing parks on its own flag,
+// a push wakes one parked thread. There is no pool wide lock, and
+// no thread spins waiting for work.
+//
+// Tasks are the caller's, they must stay put until they've run. A
+// task can push itself again from its job, which is how something
+// recurring keeps going without a round for everything to meet at.
+class WorkStealingPool
+{
+
+public:
+
+    // worker is the thread running the job, what push takes.
+    using Job = void (*)(void* context, size_t worker);
+
+    struct Task
+    {
+        Job job;
+        void* context;
+    };
+
+private:
+
+    enum : uint32_t { AWAKE, PARKED };
+
+    struct alignas(64) Worker
+    {
+        TaskDeque<Task*> tasks;
+        atomic<uint32_t> state {AWAKE};
+        // Read by the caller while the thread may still be parking.
+        atomic<size_t> steals {0};
+        atomic<size_t> parks {0};
+    };
+
+    vector<thread> threads_;
+    unique_ptr<Worker[]> workers_;  // the last one belongs to run()'s caller
+    size_t workerCount_;
+
+    // Pushed and not finished yet, the caller returns from run()
+    // when it gets to 0.
+    alignas(64) atomic<size_t> pending_ {0};
+    alignas(64) atomic<size_t> parked_ {0};
+    atomic<bool> stopping_ {false};
+
+    size_t callerIndex() const { return workerCount_ - 1; }
+
+    Task* take(size_t index)
+    {
+        Worker& own = workers_[index];
+        if(Task* task = own.tasks.steal())
+            return task;
+
+        for(size_t i = 1; i < workerCount_; i++)
+        {
+            if(Task* task = workers_[(index + i) % workerCount_].tasks.steal())
+            {
+                own.steals.fetch_add(1, memory_order_relaxed);
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    bool hasWork() const
+    {
+        for(size_t i = 0; i < workerCount_; i++)
+        {
+            if(!workers_[i].tasks.empty())
+                return true;
+        }
+        return false;
+    }
+
+    // Whoever moves a parked worker back to AWAKE takes it off the
+    // count, so it's only ever done once per park.
+    bool unpark(size_t index)
+    {
+        uint32_t parked = PARKED;
+        if(!workers_[index].state.compare_exchange_strong(parked, AWAKE))
+            return false;
+        parked_.fetch_sub(1);
+        workers_[index].state.notify_one();
+        return true;
+    }
+
+    // After a push. Everything here and in park is sequentially
+    // consistent, either the pusher sees the worker parked or the
+    // worker sees the task.
+    void wakeOne(size_t from)
+    {
+        if(parked_.load() == 0)
+            return;
+        for(size_t i = 1; i <= workerCount_; i++)
+        {
+            if(unpark((from + i) % workerCount_))
+                return;
+        }
+    }
+
+    // Sleeps until woken, unless what it would wait for is already
+    // there once it's marked as parked.
+    void park(size_t index, bool caller)
+    {
+        Worker& self = workers_[index];
+        parked_.fetch_add(1);
+        self.state.store(PARKED);
+
+        bool over = caller ? pending_.load() == 0 : stopping_.load();
+        if(over || hasWork())
+        {
+            if(self.state.exchange(AWAKE) == PARKED)
+                parked_.fetch_sub(1);
+            return;
+        }
+        self.parks.fetch_add(1, memory_order_relaxed);
+        self.state.wait(PARKED);
+    }
+
+    // Sequentially consistent, like park's look at pending_, so the
+    // last task either sees the caller parked or the caller sees 0.
+    void finish()
+    {
+        if(pending_.fetch_sub(1) == 1)
+            unpark(callerIndex());
+    }
+
+    void workerLoop(size_t index)
+    {
+        while(!stopping_.load(memory_order_relaxed))
+        {
+            if(Task* task = take(index))
+            {
+                task->job(task->context, index);
+                finish();
+                continue;
+            }
+            park(index, false);
+        }
+    }
+
+public:
+
+    // threads counts the caller, so 1 means no extra threads.
+    explicit WorkStealingPool(size_t threads)
+        : workers_(new Worker[max<size_t>(1, threads)]), workerCount_(max<size_t>(1, threads))
+    {
+        for(size_t i = 0; i + 1 < workerCount_; i++)
+            threads_.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+
+    ~WorkStealingPool()
+    {
+        stopping_.store(true);
+        for(size_t i = 0; i + 1 < workerCount_; i++)
+            unpark(i);
+        for(auto& worker : threads_)
+            worker.join();
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    size_t getThreadCount() const { return workerCount_; }
+
+    // From the thread that calls run(), outside of it.
+    void submit(Task& task)
+    {
+        push(callerIndex(), task);
+    }
+
+    // From inside a job, onto the running thread's own deque.
+    void push(size_t worker, Task& task)
+    {
+        pending_.fetch_add(1, memory_order_relaxed);
+        workers_[worker].tasks.push(&task);
+        wakeOne(worker);
+    }
+
+    // Runs until every task is done, the ones tasks push included.
+    // The caller works too.
+    void run()
+    {
+        size_t index = callerIndex();
+        while(pending_.load(memory_order_acquire) > 0)
+        {
+            if(Task* task = take(index))
+            {
+                task->job(task->context, index);
+                finish();
+                continue;
+            }
+            park(index, true);
+        }
+    }
+
+    size_t getStealCount() const
+    {
+        size_t steals = 0;
+        for(size_t i = 0; i < workerCount_; i++)
+            steals += workers_[i].steals.load(memory_order_relaxed);
+        return steals;
+    }
+
+    // Times a thread found nothing to do and went to sleep.
+    size_t getParkCount() const
+    {
+        size_t parks = 0;
+        for(size_t i = 0; i < workerCount_; i++)
+            parks += workers_[i].parks.load(memory_order_relaxed);
+        return parks;
+    }
+};
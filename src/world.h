@@ -0,0 +1,1510 @@
+#pragma once
+
+#include "archetypes.h"
+#include "behaviour.h"
+#include "entity_store.h"
+#include "events.h"
+#include "field_of_view.h"
+#include "level.h"
+#include "spatial_index.h"
+#include "thread_pool.h"
+#include "turn_history.h"
+
+class World 
+{
+
+    friend class Entity;
+    friend class Actor;
+
+private:
+
+   ChunkedMap terrain_;
+
+   // Built from the terrain and kept in step with it.
+   CollisionMask collisions_;
+
+   // Sprites drawn over the terrain for this turn only,
+   // like attacks, instead of a full copy of the map.
+   attacks turnEffects_;
+
+   limits viewport_;
+   Scene view_;
+
+   string worldMessage;
+   string debugMessage;
+
+   // Enemy randomness is a hash of these and the enemy's id, so it
+   // doesn't depend on the order enemies are processed in.
+   uint64_t seed_ = random_device{}();
+   uint64_t turn_ = 0;
+
+   ThreadPool* pool_ = nullptr;
+
+   // Set when combat events are being logged.
+   EventLog* events_ = nullptr;
+
+   // Shared by everything that chases players, only
+   // kept up to date while something does.
+   FlowField flowField_;
+   vector<position> playerPositions_;
+   vector<position> goalPositions_;
+
+   limits worldLimits_;
+
+   bool ShouldDrawEntities_;
+
+   // Frames of the scripts in the pools, declared first so it
+   // outlives them.
+   FramePool frames_;
+
+   // All enemies of one archetype, with their own spatial index and
+   // what each of them decided to do this turn, indexed by slot.
+   // Scripts are indexed by handle, so they stay put when slots move.
+   struct EnemyPool
+   {
+       EntityStore store;
+       SpatialIndex index;
+       vector<EnemyAction> actions;
+
+       vector<Behaviour> behaviours;
+       size_t scripted = 0;
+
+       // Changes along with anything in here that's saved, see
+       // writeState.
+       uint64_t version = 0;
+       // Scripts waiting for a player, and the widest radius
+       // any of them asked for since none were.
+       size_t watching = 0;
+       int32_t watchRadius = 0;
+   };
+
+   array<EnemyPool, ENEMY_TYPE_COUNT> pools_;
+
+   // Scripts waiting for a turn, by that turn modulo the wheel
+   // size. Longer waits go round again until their turn comes.
+   static constexpr size_t BEHAVIOUR_WHEEL = 64;
+   array<BehaviourLink, BEHAVIOUR_WHEEL> sleeping_;
+   // Woken by something else than time, run before the sleepers.
+   BehaviourLink woken_;
+   BehaviourLink resuming_;
+   vector< unique_ptr<Player> > players_;
+
+   SpatialIndex playerIndex_;
+
+   // What each player sees, by player slot. Only drawing with fog
+   // on looks at them, and each is brought up to date on the way.
+   vector<FieldOfView> sights_;
+   bool fog_ = false;
+
+   // Reused between queries so hit tests don't allocate.
+   vector<EntityId> idScratch_;
+   vector<position> attackCells_;
+   vector<uint8_t> landed_;
+
+public:
+
+   struct Collider
+   {
+       position pos_;
+       char sprite_;
+   };
+
+private:
+
+   vector<Collider> colliders_;
+
+   // Set when the terrain comes from a mapped level file.
+   shared_ptr<const LevelFile> level_;
+
+   // How each of the last turns started, for undo.
+   TurnHistory history_;
+   // Bytes the last recordTurn actually wrote.
+   uint64_t historyWritten_ = 0;
+
+   // Versions of the parts of the state writeState tells apart,
+   // each taken from changes_ when its part changes. They only go
+   // up, whatever gets loaded, so a part with the same version as
+   // in an older snapshot really is the same.
+   uint64_t changes_ = 0;
+   uint64_t terrainVersion_ = 0;
+   uint64_t fieldVersion_ = 0;
+
+   uint64_t nextVersion()
+   {
+       return ++changes_;
+   }
+
+   // Along with the pools, everything else is new too, nothing
+   // from a snapshot taken before is reused.
+   void resetPools()
+   {
+       for(size_t type = 0; type < pools_.size(); type++)
+       {
+           pools_[type] = EnemyPool{};
+           pools_[type].store.typeBits = static_cast<EntityId>(type) << ENEMY_ID_TYPE_SHIFT;
+           pools_[type].index.reset(worldLimits_);
+           pools_[type].version = nextVersion();
+       }
+       terrainVersion_ = nextVersion();
+       fieldVersion_   = nextVersion();
+   }
+
+   void setupBaseScene()
+   {
+       addSpriteCollider('D', position(5, 5)); 
+       addSpriteCollider('W', position(5, 4)); 
+       addSpriteCollider('W', position(6, 4)); 
+       addSpriteCollider('W', position(7, 4)); 
+       addSpriteCollider('W', position(7, 5)); 
+       addSpriteCollider('W', position(7, 6)); 
+       addSpriteCollider('W', position(6, 6)); 
+       addSpriteCollider('W', position(5, 6)); 
+   }
+
+   // Sized for the biggest attack so none allocates after the first.
+   void reserveAttackScratch()
+   {
+       idScratch_.reserve(MAX_ATTACK_CELLS);
+       turnEffects_.reserve(MAX_ATTACK_CELLS);
+       attackCells_.reserve(MAX_ATTACK_CELLS);
+       landed_.reserve(MAX_ATTACK_CELLS);
+   }
+
+   bool inViewport(position pos, position origin, limits size) const
+   {
+       return pos.first >= origin.first && pos.first < origin.first + size.first
+           && pos.second >= origin.second && pos.second < origin.second + size.second;
+   }
+
+public:
+
+   enum class WORLD_CONSTANTS : size_t {
+       WORLD_HEIGHT = 10,
+       WORLD_WIDTH = 60,
+       // Chunk indices and the spatial index keys are
+       // sized with this in mind, don't go past it.
+       MAX_WORLD_SIDE = 1 << 17,
+   };
+
+   static limits defaultWorldLimits()
+   {
+       return limits(static_cast<int>(WORLD_CONSTANTS::WORLD_HEIGHT),
+                  static_cast<int>(WORLD_CONSTANTS::WORLD_WIDTH));
+   }
+
+   explicit World(limits worldLimits = defaultWorldLimits()) :
+       viewport_ {defaultWorldLimits()},
+       worldLimits_ {worldLimits}
+   { 
+       terrain_.reset(worldLimits_, '.');
+       collisions_.reset(worldLimits_);
+       setupBaseScene();
+       resetPools();
+       playerIndex_.reset(worldLimits_);
+       reserveAttackScratch();
+   }
+
+   // Seeded worlds always make the same enemy moves.
+   World(limits worldLimits, unsigned seed) : World(worldLimits)
+   {
+       seed_ = seed;
+   }
+
+   explicit World(unsigned seed) : World(defaultWorldLimits(), seed) {}
+
+   // Terrain is used in place from the mapping, only the
+   // collider table is copied out.
+   World(shared_ptr<const LevelFile> level, unsigned seed) :
+       viewport_ {defaultWorldLimits()},
+       worldLimits_ {level->getLimits()},
+       level_ {level}
+   {
+       auto& header = level_->getHeader();
+       terrain_.attach(worldLimits_, header.ground, level_->getData(), level_->getChunkOffsets());
+       collisions_.build(terrain_, worldLimits_);
+
+       colliders_.resize(header.colliderCount);
+       const LevelCollider* colliders = level_->getColliders();
+       for(size_t i = 0; i < colliders_.size(); i++)
+       {
+           colliders_[i].pos_    = position(colliders[i].row, colliders[i].column);
+           colliders_[i].sprite_ = colliders[i].sprite;
+       }
+
+       resetPools();
+       playerIndex_.reset(worldLimits_);
+       reserveAttackScratch();
+       seed_ = seed;
+   }
+
+   // Writes everything needed to carry on from this exact turn.
+   // When only hashing, what's just on screen (messages and turn
+   // effects) is left out, and nothing is allocated. Into pages, the
+   // terrain, the flow field and each pool are only written when
+   // they changed since the last snapshot, the rest is small.
+   void writeState(SnapshotWriter& writer) const
+   {
+       bool full = !writer.isHashOnly();
+
+       if(!writer.part(terrainVersion_))
+           writeTerrain(writer);
+
+       writer.part(0);
+       if(full)
+       {
+           writeRecords(writer, turnEffects_, attackSprite, attackPosition);
+           writer.text(worldMessage);
+           writer.text(debugMessage);
+       }
+
+       writer.value(seed_);
+       writer.value(turn_);
+
+       if(full && !writer.part(fieldVersion_))
+           flowField_.write(writer);
+
+       writer.part(0);
+       writer.value<uint64_t>(players_.size());
+       for(auto& player : players_)
+       {
+           writer.text(player->name_);
+           writer.value<int32_t>(player->health_);
+           writer.value<int32_t>(player->attack_);
+           writer.value<int32_t>(player->defense_);
+           writer.value<char>(player->sprite_);
+           writer.value(player->entityPosition_);
+
+           auto& history = player->lastPositions_;
+           writer.value<uint64_t>(history.size());
+           for(size_t i = 0; i < history.size(); i++)
+               writer.value(history[i]);
+
+           writeRecords(writer, player->attackPositions_, attackSprite, attackPosition);
+           writer.value(player->lastAttackedEnemy);
+       }
+
+       for(auto& pool : pools_)
+       {
+           if(!writer.part(pool.version))
+               writePool(writer, pool);
+       }
+   }
+
+   // Same layout as the level file's collider table.
+   template<class Items, class GetSprite, class GetPosition>
+   static void writeRecords(SnapshotWriter& writer, const Items& items, GetSprite getSprite,
+           GetPosition getPosition)
+   {
+       writer.value<uint64_t>(items.size());
+       for(auto& item : items)
+       {
+           LevelCollider record{};
+           record.row    = getPosition(item).first;
+           record.column = getPosition(item).second;
+           record.sprite = getSprite(item);
+           writer.value(record);
+       }
+   }
+
+   static char attackSprite(const pair<char, position>& attack) { return attack.first; }
+   static position attackPosition(const pair<char, position>& attack) { return attack.second; }
+
+   void writeTerrain(SnapshotWriter& writer) const
+   {
+       writer.value<int32_t>(worldLimits_.first);
+       writer.value<int32_t>(worldLimits_.second);
+       writer.text(level_ ? level_->getPath() : string_view());
+       writer.value<char>(terrain_.getGround());
+
+       uint64_t ownedChunks = 0;
+       for(size_t i = 0; i < terrain_.getChunkCount(); i++)
+           ownedChunks += terrain_.isOwned(i);
+       writer.value<uint64_t>(ownedChunks);
+       for(size_t i = 0; i < terrain_.getChunkCount(); i++)
+       {
+           if(terrain_.isOwned(i))
+               writer.value<uint64_t>(i);
+       }
+       writer.section();
+       for(size_t i = 0; i < terrain_.getChunkCount(); i++)
+       {
+           if(terrain_.isOwned(i))
+               writer.bytes(terrain_.getChunk(i), ChunkedMap::CHUNK_CELLS);
+       }
+
+       writer.section();
+       writeRecords(writer, colliders_, [](auto& c) { return c.sprite_; }, [](auto& c) { return c.pos_; });
+   }
+
+   void writePool(SnapshotWriter& writer, const EnemyPool& pool) const
+   {
+       bool full = !writer.isHashOnly();
+
+       auto& store = pool.store;
+       writer.array(store.generations);
+       writer.array(store.freeHandles);
+       writer.array(store.positions);
+       writer.array(store.health);
+       writer.array(store.attack);
+       writer.array(store.defense);
+       writer.array(store.sprites);
+       writer.array(store.homes);
+       writer.array(store.ids);
+
+       if(full)
+       {
+           writer.value<uint64_t>(store.names.size());
+           for(auto& name : store.names)
+           {
+               writer.value(name.first);
+               writer.text(name.second);
+           }
+       }
+       else
+       {
+           // Summed so the hash table's order doesn't matter.
+           uint64_t names = 0;
+           for(auto& name : store.names)
+           {
+               Checksum checksum;
+               checksum.update(&name.first, sizeof(name.first));
+               checksum.update(name.second.data(), name.second.size());
+               names += checksum.finish();
+           }
+           writer.value(names);
+       }
+
+       writer.value<uint64_t>(pool.scripted);
+       for(auto& behaviour : pool.behaviours)
+       {
+           if(!behaviour)
+               continue;
+           auto& promise = behaviour.promise();
+           writer.value(promise.self);
+           writer.text(promise.name);
+           writer.value(promise.wait);
+           writer.value(promise.argument);
+           writer.value(promise.wakeTurn);
+           writer.value(promise.state);
+       }
+   }
+
+   bool save(const string& path) const
+   {
+       ofstream out(path, ios::binary | ios::trunc);
+       if(!out)
+           return false;
+
+       SnapshotHeader header{};
+       out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+       SnapshotWriter writer{&out};
+       writeState(writer);
+
+       memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+       header.version     = SNAPSHOT_VERSION;
+       header.payloadSize = writer.getSize();
+       header.checksum    = writer.getChecksum();
+
+       out.seekp(0);
+       out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+       return static_cast<bool>(out);
+   }
+
+   // Hash of the simulated state, equal worlds hash equal. Cheap
+   // enough to take every turn.
+   uint64_t stateHash() const
+   {
+       SnapshotWriter writer{};
+       writeState(writer);
+       return writer.getChecksum();
+   }
+
+   // Replaces the whole state with a snapshot. Nothing changes
+   // unless the snapshot reads back completely and checks out.
+   bool load(const string& path)
+   {
+       ifstream in(path, ios::binary);
+       if(!in)
+           return false;
+
+       in.seekg(0, ios::end);
+       size_t fileSize = static_cast<size_t>(in.tellg());
+       in.seekg(0, ios::beg);
+       if(fileSize < sizeof(SnapshotHeader))
+           return false;
+
+       vector<char> file(fileSize);
+       in.read(file.data(), fileSize);
+       if(!in)
+           return false;
+
+       SnapshotHeader header;
+       memcpy(&header, file.data(), sizeof(header));
+       if(memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0
+               || header.version != SNAPSHOT_VERSION
+               || header.payloadSize != fileSize - sizeof(header))
+           return false;
+
+       Checksum checksum;
+       checksum.update(file.data() + sizeof(header), header.payloadSize);
+       if(checksum.finish() != header.checksum)
+           return false;
+
+       return readState(file.data() + sizeof(header), header.payloadSize);
+   }
+
+   // Replaces the whole state with what writeState wrote, or
+   // changes nothing if it doesn't read back completely.
+   bool readState(const char* payload, size_t size)
+   {
+       SnapshotReader reader{payload, size};
+
+       limits newLimits;
+       newLimits.first  = reader.value<int32_t>();
+       newLimits.second = reader.value<int32_t>();
+       string levelPath = reader.text();
+       char ground = reader.value<char>();
+
+       int maxSide = static_cast<int>(WORLD_CONSTANTS::MAX_WORLD_SIDE);
+       if(!reader.ok() || newLimits.first <= 0 || newLimits.second <= 0
+               || newLimits.first > maxSide || newLimits.second > maxSide)
+           return false;
+
+       shared_ptr<const LevelFile> newLevel;
+       ChunkedMap newTerrain;
+       if(!levelPath.empty())
+       {
+           // Undo goes back to the same level over and over, it stays mapped.
+           newLevel = level_ && level_->getPath() == levelPath ? level_ : LevelFile::open(levelPath);
+           if(!newLevel || newLevel->getLimits() != newLimits)
+               return false;
+           newTerrain.attach(newLimits, ground, newLevel->getData(), newLevel->getChunkOffsets());
+       }
+       else
+       {
+           newTerrain.reset(newLimits, ground);
+       }
+
+       vector<uint64_t> ownedChunks;
+       reader.array(ownedChunks);
+       for(auto index : ownedChunks)
+       {
+           const char* chunk = reader.view(ChunkedMap::CHUNK_CELLS);
+           if(!chunk || index >= newTerrain.getChunkCount())
+               return false;
+           newTerrain.setChunk(index, chunk);
+       }
+
+       vector<LevelCollider> colliderRecords, effectRecords;
+       reader.array(colliderRecords);
+       reader.array(effectRecords);
+
+       vector<Collider> newColliders(colliderRecords.size());
+       for(size_t i = 0; i < colliderRecords.size(); i++)
+           newColliders[i] = { position(colliderRecords[i].row, colliderRecords[i].column), colliderRecords[i].sprite };
+
+       attacks newEffects;
+       newEffects.reserve(max(effectRecords.size(), MAX_ATTACK_CELLS));
+       for(auto& record : effectRecords)
+           newEffects.push_back( pair(record.sprite, position(record.row, record.column)) );
+
+       string newMessage   = reader.text();
+       string newDebug     = reader.text();
+       uint64_t newSeed    = reader.value<uint64_t>();
+       uint64_t newTurn    = reader.value<uint64_t>();
+
+       FlowField newField;
+       if(!newField.read(reader))
+           return false;
+
+       uint64_t playerCount = reader.value<uint64_t>();
+       vector< unique_ptr<Player> > newPlayers;
+       for(uint64_t i = 0; reader.ok() && i < playerCount; i++)
+       {
+           string name = reader.text();
+           int health  = reader.value<int32_t>();
+           int attack  = reader.value<int32_t>();
+           int defense = reader.value<int32_t>();
+           char sprite = reader.value<char>();
+           position pos = reader.value<position>();
+
+           auto player = make_unique<Player>(name, health, attack, defense, pos, sprite);
+
+           uint64_t historySize = reader.value<uint64_t>();
+           if(historySize > 3)
+               return false;
+           vector<position> history(historySize);
+           for(auto& entry : history)
+               entry = reader.value<position>();
+           for(auto entry = history.rbegin(); entry != history.rend(); entry++)
+               player->lastPositions_.push(*entry);
+
+           vector<LevelCollider> attackRecords;
+           reader.array(attackRecords);
+           for(auto& record : attackRecords)
+               player->pushAttack(record.sprite, position(record.row, record.column));
+
+           player->lastAttackedEnemy = reader.value<EntityId>();
+           newPlayers.push_back(move(player));
+       }
+
+       array<EntityStore, ENEMY_TYPE_COUNT> newStores;
+       array<vector<ScriptRecord>, ENEMY_TYPE_COUNT> newScripts;
+       for(size_t type = 0; type < newStores.size(); type++)
+       {
+           auto& store = newStores[type];
+           store.typeBits = static_cast<EntityId>(type) << ENEMY_ID_TYPE_SHIFT;
+           reader.array(store.generations);
+           reader.array(store.freeHandles);
+           reader.array(store.positions);
+           reader.array(store.health);
+           reader.array(store.attack);
+           reader.array(store.defense);
+           reader.array(store.sprites);
+           reader.array(store.homes);
+           reader.array(store.ids);
+
+           size_t enemyCount = store.ids.size();
+           if(store.positions.size() != enemyCount || store.health.size() != enemyCount
+                   || store.attack.size() != enemyCount || store.defense.size() != enemyCount
+                   || store.sprites.size() != enemyCount || store.homes.size() != enemyCount
+                   || !store.linkHandles())
+               return false;
+
+           uint64_t nameCount = reader.value<uint64_t>();
+           for(uint64_t i = 0; reader.ok() && i < nameCount; i++)
+           {
+               EntityId id = reader.value<EntityId>();
+               store.names[id] = reader.text();
+           }
+
+           uint64_t scriptCount = reader.value<uint64_t>();
+           if(!reader.ok() || scriptCount > enemyCount)
+               return false;
+           vector<uint8_t> scriptedHandles(store.generations.size());
+           for(uint64_t i = 0; i < scriptCount; i++)
+           {
+               ScriptRecord record;
+               record.id       = reader.value<EntityId>();
+               string name     = reader.text();
+               record.wait     = reader.value<BehaviourWait>();
+               record.argument = reader.value<int32_t>();
+               record.wakeTurn = reader.value<uint64_t>();
+               record.state    = reader.value<BehaviourState>();
+               record.script   = BehaviourScripts::find(name);
+               record.name     = BehaviourScripts::nameOf(record.script);
+
+               if(!reader.ok() || !record.script || store.find(record.id) >= enemyCount
+                       || scriptedHandles[handleIndexOf(record.id)]++
+                       || record.wait >= BehaviourWait::DONE
+                       || (record.wait == BehaviourWait::TURNS && record.wakeTurn < newTurn))
+                   return false;
+               newScripts[type].push_back(record);
+           }
+       }
+
+       if(!reader.ok() || !reader.atEnd())
+           return false;
+
+       // Everything checked out, swap the new state in.
+       worldLimits_ = newLimits;
+       level_       = newLevel;
+       terrain_     = move(newTerrain);
+       collisions_.build(terrain_, worldLimits_);
+       colliders_   = move(newColliders);
+       turnEffects_ = move(newEffects);
+       seed_        = newSeed;
+       turn_        = newTurn;
+       worldMessage = newMessage;
+       debugMessage = newDebug;
+       players_     = move(newPlayers);
+       flowField_   = move(newField);
+
+       resetPools();
+       for(size_t type = 0; type < pools_.size(); type++)
+       {
+           auto& pool = pools_[type];
+           pool.store = move(newStores[type]);
+           for(size_t slot = 0; slot < pool.store.size(); slot++)
+               pool.index.insert(slot, pool.store.positions[slot]);
+           for(auto& record : newScripts[type])
+               restoreBehaviour(pool, record);
+       }
+       playerIndex_.reset(worldLimits_);
+       sights_.assign(players_.size(), FieldOfView{});
+       for(size_t slot = 0; slot < players_.size(); slot++)
+       {
+           players_[slot]->world_ = this;
+           players_[slot]->slot_  = slot;
+           playerIndex_.insert(slot, players_[slot]->getPosition());
+       }
+       return true;
+   }
+
+   // Adds the entities listed in the level's spawn table.
+   void spawnLevelEntities()
+   {
+       if(!level_)
+           return;
+
+       const LevelSpawn* spawns = level_->getSpawns();
+       for(size_t i = 0; i < level_->getHeader().spawnCount; i++)
+       {
+           auto& spawn = spawns[i];
+           string name(level_->getName(spawn));
+           position pos(spawn.row, spawn.column);
+
+           if(spawn.entityType == static_cast<uint8_t>(Entity::ENTYPE::PLAYER))
+           {
+               Player player(name, spawn.health, spawn.attack, spawn.defense, pos, spawn.sprite);
+               addEntity(player);
+           }
+           else if(spawn.enemyType < ENEMY_TYPE_COUNT)
+           {
+               spawnEnemy(static_cast<ENEMY_TYPE>(spawn.enemyType), name, spawn.health,
+                       spawn.attack, spawn.defense, pos, spawn.sprite);
+           }
+       }
+   }
+
+   const vector<Collider>& getColliders() const { return colliders_; }
+
+   void addSpriteCollider(char Sprite, position Pos)
+   {
+       terrain_.set(Pos, Sprite);
+       collisions_.setBlocked(Pos, Sprite != terrain_.getGround());
+       Collider coll = { Pos, Sprite };
+       colliders_.push_back(coll);
+       flowField_.invalidate();
+       terrainVersion_ = nextVersion();
+       fieldVersion_   = nextVersion();
+       for(auto& sight : sights_)
+       {
+           if(sight.covers(Pos))
+               sight.invalidate();
+       }
+   }
+
+   // For now only enemies can be released.
+   void removeEnemy(EnemyPool& pool, size_t slot)
+   {
+       logEvent(EventKind::REMOVED, pool.store.ids[slot], 0, pool.store.positions[slot]);
+       pool.version = nextVersion();
+       pool.index.erase(slot);
+       if(Behaviour* behaviour = findBehaviour(pool, slot))
+           endBehaviour(pool, *behaviour);
+
+       size_t moved = pool.store.remove(slot);
+       if(moved != EntityStore::npos)
+           pool.index.rename(moved, slot);
+   }
+
+   // Returns true when the enemy died and was removed.
+   bool damageEnemy(EntityId id, int damage, EntityId attacker)
+   {
+       auto& pool = pools_[static_cast<size_t>(enemyTypeOf(id))];
+       size_t slot = pool.store.find(id);
+       if(slot == EntityStore::npos)
+           return false;
+
+       int newHealth = pool.store.health[slot] - damage;
+       logEvent(EventKind::DAMAGE, attacker, id, pool.store.positions[slot], position(),
+               damage, max(0, newHealth));
+       if(newHealth > 0)
+       {
+           pool.store.health[slot] = newHealth;
+           pool.version = nextVersion();
+           Behaviour* behaviour = findBehaviour(pool, slot);
+           if(behaviour && behaviour->promise().wait == BehaviourWait::HURT)
+               wakeBehaviour(pool, *behaviour);
+           return false;
+       }
+
+       removeEnemy(pool, slot);
+       return true;
+   }
+
+   void moveEnemy(EnemyPool& pool, size_t slot, position pos)
+   {
+       position res = Entity::clampPosition(pos, worldLimits_);
+       logEvent(EventKind::MOVE, pool.store.ids[slot], 0, pool.store.positions[slot], res);
+       pool.index.move(slot, pool.store.positions[slot], res);
+       pool.store.positions[slot] = res;
+       pool.version = nextVersion();
+   }
+
+   bool hasEnemyAt(position pos) const
+   {
+       for(auto& pool : pools_)
+       {
+           if(!pool.index.at(pos).empty())
+               return true;
+       }
+       return false;
+   }
+
+   // Ids stay valid while enemies are being removed, slots don't.
+   // In cell order, one index lookup per cell and pool, so the cost
+   // follows cells plus hits and not the number of enemies. Within
+   // a cell by id, the index's order depends on how enemies got
+   // there and isn't the same in a loaded world.
+   // The returned buffer is overwritten by the next call.
+   const vector<EntityId>& collectEnemyIdsIn(const vector<position>& cells)
+   {
+       idScratch_.clear();
+       for(auto& pos : cells)
+       {
+           for(auto& pool : pools_)
+           {
+               size_t first = idScratch_.size();
+               for(auto slot : pool.index.at(pos))
+                   idScratch_.push_back(pool.store.ids[slot]);
+               sort(idScratch_.begin() + first, idScratch_.end());
+           }
+       }
+       return idScratch_;
+   }
+
+   // The cells of pattern thrown from origin that land, in pattern
+   // order. Overwritten by the next call.
+   const vector<position>& resolveAttackCells(const AttackPattern& pattern, Facing facing,
+           position origin)
+   {
+       attackCells_.clear();
+       landed_.resize(pattern.count);
+       for(size_t i = 0; i < pattern.count; i++)
+       {
+           const PatternCell& cell = pattern.cells[i];
+           position offset = rotateOffset(cell.row, cell.column, facing);
+           position pos(origin.first + offset.first, origin.second + offset.second);
+
+           landed_[i] = (cell.parent < 0 || landed_[cell.parent]) && isPassable(pos);
+           if(landed_[i])
+               attackCells_.push_back(pos);
+       }
+       return attackCells_;
+   }
+
+   // Health of a living enemy, or -1.
+   int getEnemyHealth(EntityId id) const
+   {
+       size_t type = static_cast<size_t>(enemyTypeOf(id));
+       if(type >= pools_.size())
+           return -1;
+       size_t slot = pools_[type].store.find(id);
+       return slot == EntityStore::npos ? -1 : pools_[type].store.health[slot];
+   }
+
+   const EntityStore& getEnemies(ENEMY_TYPE type) const
+   {
+       return pools_[static_cast<size_t>(type)].store;
+   }
+
+   size_t getEnemyCount() const
+   {
+       size_t count = 0;
+       for(auto& pool : pools_)
+           count += pool.store.size();
+       return count;
+   }
+
+   EntityId spawnEnemy(ENEMY_TYPE type, const string& name, int health, int attack,
+           int defense, position pos, char sprite)
+   {
+       auto& pool = pools_[static_cast<size_t>(type)];
+       size_t slot = pool.store.add(name, health, attack, defense, sprite,
+               Entity::clampPosition(pos, worldLimits_));
+       pool.index.insert(slot, pool.store.positions[slot]);
+       pool.version = nextVersion();
+       return pool.store.ids[slot];
+   }
+
+   template<class Archetype>
+   EntityId spawnEnemy(position pos, const string& name)
+   {
+       return spawnEnemy(Archetype::type, name, Archetype::health, Archetype::attack,
+               Archetype::defense, pos, Archetype::sprite);
+   }
+
+   // What a script written for the enemy id takes as its first
+   // parameter.
+   Actor getActor(EntityId id)
+   {
+       return Actor(*this, id);
+   }
+
+   // Hands an enemy over to a script, which first runs in the next
+   // enemy turn. One script per enemy at a time, false when it
+   // already has one, is gone or the script isn't registered in
+   // BehaviourScripts. The archetype's decide takes over again once
+   // the script returns. Scripts are saved with their enemy and
+   // started again from their state on load and undo.
+   bool runBehaviour(EntityId id, BehaviourScript script)
+   {
+       size_t type = static_cast<size_t>(enemyTypeOf(id));
+       string_view name = BehaviourScripts::nameOf(script);
+       if(type >= pools_.size() || name.empty())
+           return false;
+
+       auto& pool = pools_[type];
+       size_t slot = pool.store.find(id);
+       if(slot == EntityStore::npos || findBehaviour(pool, slot))
+           return false;
+
+       ScriptRecord record;
+       record.id       = id;
+       record.script   = script;
+       record.name     = name;
+       record.wait     = BehaviourWait::TURNS;
+       record.wakeTurn = turn_;
+       restoreBehaviour(pool, record);
+       return true;
+   }
+
+   // Slot of the first player within radius of center, or -1.
+   int32_t findPlayerSlotNear(position center, int radius) const
+   {
+       auto player = findPlayerNear(center, radius);
+       return player ? static_cast<int32_t>(player->slot_) : -1;
+   }
+
+   // Random bits for one enemy this turn, the same whichever
+   // thread asks.
+   uint64_t wanderBits(EntityId id) const
+   {
+       return mixBits(seed_ ^ mixBits(turn_ ^ mixBits(id)));
+   }
+
+   // Looks only at the cells within radius of center,
+   // returns the first player found.
+   Player* findPlayerNear(position center, int radius) const
+   {
+       Player* found = nullptr;
+       playerIndex_.forEachInRect(position(center.first - radius, center.second - radius),
+               limits(2 * radius + 1, 2 * radius + 1), [&](uint32_t slot, position) {
+           found = players_[slot].get();
+           return false;
+       });
+       return found;
+   }
+
+   const ChunkedMap& getTerrain() const
+   {
+       return terrain_;
+   }
+
+   void addTurnEffect(char sprite, position pos)
+   {
+       if(terrain_.inside(pos))
+           turnEffects_.push_back( pair(sprite, pos) );
+   }
+
+   // Every turn loop starts its turns here, so this is where
+   // they're kept for undo.
+   void resetWorldMap()
+   {
+       if(history_.isEnabled())
+           recordTurn();
+       turnEffects_.clear();
+   }
+
+   void recordTurn()
+   {
+       PROFILE_SCOPE(RECORD_TURN);
+       SnapshotPager pager{history_.newest()};
+       SnapshotWriter writer{&pager};
+       writeState(writer);
+       history_.push(pager.finish());
+       historyWritten_ = writer.getSize();
+   }
+
+   // Turns kept for undo, 0 turns it off.
+   void setHistoryDepth(size_t turns)
+   {
+       history_.setDepth(turns);
+   }
+
+   bool hasHistory() const
+   {
+       return history_.isEnabled();
+   }
+
+   bool canUndo(size_t turns) const
+   {
+       return turns > 0 && turns <= getUndoDepth();
+   }
+
+   // The turn being played was kept when it started,
+   // it can't be undone to.
+   size_t getUndoDepth() const
+   {
+       return history_.size() > 0 ? history_.size() - 1 : 0;
+   }
+
+   size_t getHistoryBytes() const
+   {
+       return history_.getBytes();
+   }
+
+   // What keeping the last turn wrote, only the parts that
+   // changed since the turn before get written.
+   uint64_t getHistoryWritten() const
+   {
+       return historyWritten_;
+   }
+
+   // Puts everything back the way it was when the turn that many
+   // turns ago started, its enemies move the same way again. Like
+   // load, this replaces every player.
+   bool undo(size_t turns)
+   {
+       if(!canUndo(turns))
+           return false;
+
+       vector<char> payload;
+       history_.get(turns).snapshot.copyTo(payload);
+       auto sights = move(sights_);
+       if(!readState(payload.data(), payload.size()))
+       {
+           sights_ = move(sights);
+           return false;
+       }
+
+       // What was explored stays explored, only what's in
+       // sight is worked out again.
+       if(sights.size() == sights_.size())
+       {
+           sights_ = move(sights);
+           for(auto& sight : sights_)
+               sight.invalidate();
+       }
+
+       // The turn gone back to is kept again when it starts over.
+       history_.dropNewest(turns + 1);
+       return true;
+   }
+
+   void setViewport(limits size)
+   {
+       viewport_ = size;
+   }
+
+   // Top left corner of the viewport, centred on
+   // the player but never hanging off the world.
+   position getViewportOrigin(size_t playerIndex = 0) const
+   {
+       limits size = getViewportSize();
+       position center = playerIndex < players_.size()
+           ? players_[playerIndex]->getPosition() : position(0, 0);
+
+       position origin(center.first - size.first / 2, center.second - size.second / 2);
+       origin.first  = max(0, min(origin.first, worldLimits_.first - size.first));
+       origin.second = max(0, min(origin.second, worldLimits_.second - size.second));
+       return origin;
+   }
+
+   limits getViewportSize() const
+   {
+       return limits(min(viewport_.first, worldLimits_.first),
+               min(viewport_.second, worldLimits_.second));
+   }
+
+   // With fog on, players only see what their field of view
+   // reaches and the terrain they've seen before.
+   void setFog(bool value)
+   {
+       fog_ = value;
+   }
+
+   // Brought up to date first, which only costs anything when the
+   // player moved or a wall near them changed.
+   const FieldOfView& getSight(size_t playerIndex)
+   {
+       sights_[playerIndex].update(players_[playerIndex]->getPosition(), collisions_, worldLimits_);
+       return sights_[playerIndex];
+   }
+
+   // Only the viewport is built, so the cost follows
+   // its size and not the size of the world.
+   void drawMap(ostream& out = cout, size_t playerIndex = 0)
+   {
+       PROFILE_SCOPE(DRAW_MAP);
+       limits size = getViewportSize();
+       position origin = getViewportOrigin(playerIndex);
+       PROFILE_COUNT(CELLS, size_t(size.first) * size.second);
+
+       const FieldOfView* sight = fog_ && playerIndex < players_.size() ? &getSight(playerIndex) : nullptr;
+       auto seen = [sight](position pos) { return !sight || sight->isVisible(pos); };
+
+       view_.resize(size.first);
+       for(int row = 0; row < size.first; row++)
+       {
+           view_[row].resize(size.second);
+           terrain_.copyRow(origin.first + row, origin.second, size.second, view_[row].data());
+           if(sight)
+               sight->hideUnseen(origin.first + row, origin.second, size.second, view_[row].data());
+       }
+
+       for(auto& effect : turnEffects_)
+       {
+           if(inViewport(effect.second, origin, size) && seen(effect.second))
+               view_[effect.second.first - origin.first][effect.second.second - origin.second] = effect.first;
+       }
+
+       if(ShouldDrawEntities_)
+       { 
+           for(auto& pool : pools_)
+           {
+               pool.index.forEachInRect(origin, size, [&](uint32_t slot, position pos) {
+                   if(seen(pos))
+                       view_[pos.first - origin.first][pos.second - origin.second] = pool.store.sprites[slot];
+                   return true;
+               });
+           }
+
+           for(auto& player : players_)
+           {
+               position pos = player->getPosition();
+               if(inViewport(pos, origin, size) && seen(pos))
+                   view_[pos.first - origin.first][pos.second - origin.second] = player->getSprite();
+           }
+       }
+
+       for(auto& l : view_)
+           out << l << '\n';
+   }
+
+   void drawPlayerActions()
+   {
+       PROFILE_SCOPE(PLAYER_ACTIONS);
+       PROFILE_COUNT(ENTITIES, players_.size());
+
+       for(auto& player : players_)
+       {
+            setDebugMessage(player->getName());
+            const attacks& at = player->getAttackPositions();
+
+            for(auto a : at)
+            {
+                setDebugMessage(to_string(a.first));
+                addTurnEffect(a.first, a.second);
+            }
+       }
+   }
+
+   void drawWorldInformation(ostream& out = cout, size_t playerIndex = 0)
+   {
+       auto player = getPlayer(playerIndex);
+       int health = getEnemyHealth(player->getLastAttackedEnemy());
+       if(health >= 0)
+       {
+          out << "\tEnemy health : " << health << endl;
+       }
+   }
+
+   const vector< unique_ptr<Player> >& getPlayers() const
+   {
+      return players_;
+   }
+
+   limits getWorldLimits() const
+   {
+       return worldLimits_;
+   }
+
+   void setShouldDrawEntities(bool value)
+   {   
+        ShouldDrawEntities_ = value;
+   }
+
+   // Enemies go through spawnEnemy.
+   void addEntity(Player& player)
+   {
+      player.setPosition(player.getPosition(), worldLimits_);
+
+      players_.push_back( make_unique<Player>(player) ); 
+
+      auto& added = players_.back();
+      added->world_ = this;
+      added->slot_  = players_.size() - 1;
+      playerIndex_.insert(added->slot_, added->getPosition());
+      sights_.emplace_back();
+   }
+
+   // The last player takes the freed slot, returns the slot it came
+   // from (npos when nothing moved) so callers can follow it.
+   size_t removePlayer(size_t slot)
+   {
+      playerIndex_.erase(slot);
+
+      size_t last = players_.size() - 1;
+      if(slot != last)
+      {
+          players_[slot] = move(players_[last]);
+          players_[slot]->slot_ = slot;
+          playerIndex_.rename(last, slot);
+          sights_[slot] = move(sights_[last]);
+      }
+      players_.pop_back();
+      sights_.pop_back();
+      return slot != last ? last : EntityStore::npos;
+   }
+
+   // splitmix64, good enough to spread (seed, turn, id) around.
+   static uint64_t mixBits(uint64_t x)
+   {
+       x += 0x9e3779b97f4a7c15ull;
+       x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+       x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+       return x ^ (x >> 31);
+   }
+
+   // Scripted enemies stay put unless their script says otherwise.
+   template<class Archetype>
+   void decideEnemies(EnemyPool& pool, size_t begin, size_t end) const
+   {
+       bool scripted = pool.scripted > 0;
+       for(size_t i = begin; i < end; i++)
+       {
+           EnemyAction& action = pool.actions[i];
+           action.player = -1;
+           action.target = pool.store.positions[i];
+           if(scripted && findBehaviour(pool, i))
+               continue;
+           Archetype::decide(*this, pool.store, i, action);
+       }
+   }
+
+   Behaviour* findBehaviour(EnemyPool& pool, size_t slot) const
+   {
+       uint32_t index = handleIndexOf(pool.store.ids[slot]);
+       return index < pool.behaviours.size() && pool.behaviours[index]
+           ? &pool.behaviours[index] : nullptr;
+   }
+
+   // Ending a script frees its frame, which takes it off
+   // whatever list it waited in.
+   void endBehaviour(EnemyPool& pool, Behaviour& behaviour)
+   {
+       if(behaviour.promise().wait == BehaviourWait::PLAYER)
+           pool.watching--;
+       behaviour = Behaviour{};
+       pool.scripted--;
+       pool.version = nextVersion();
+   }
+
+   void wakeBehaviour(EnemyPool& pool, Behaviour& behaviour)
+   {
+       behaviour.promise().wait = BehaviourWait::NONE;
+       woken_.pushBack(behaviour.promise());
+       pool.version = nextVersion();
+   }
+
+   // Puts a suspended script where what it waits for will find it.
+   void fileBehaviour(EnemyPool& pool, Behaviour::promise_type& promise)
+   {
+       switch(promise.wait)
+       {
+           case BehaviourWait::NONE:
+               woken_.pushBack(promise);
+               break;
+           case BehaviourWait::TURNS:
+               sleeping_[promise.wakeTurn % BEHAVIOUR_WHEEL].pushBack(promise);
+               break;
+           case BehaviourWait::PLAYER:
+               pool.watching++;
+               pool.watchRadius = max(pool.watchRadius, promise.argument);
+               break;
+           default:
+               break;
+       }
+   }
+
+   // A script as saved, or as it is before its first turn.
+   struct ScriptRecord
+   {
+       EntityId id = 0;
+       BehaviourScript script = nullptr;
+       string_view name;
+       BehaviourWait wait = BehaviourWait::NONE;
+       int32_t argument = 0;
+       uint64_t wakeTurn = 0;
+       BehaviourState state;
+   };
+
+   // Starts the script over, suspended on what the record waits
+   // for. It reads its state on the way in and carries on from
+   // there, see Behaviour.
+   void restoreBehaviour(EnemyPool& pool, const ScriptRecord& record)
+   {
+       uint32_t index = handleIndexOf(record.id);
+       if(index >= pool.behaviours.size())
+           pool.behaviours.resize(pool.store.generations.size());
+       pool.behaviours[index] = record.script(getActor(record.id));
+       pool.scripted++;
+       pool.version = nextVersion();
+
+       auto& promise = pool.behaviours[index].promise();
+       promise.name     = record.name;
+       promise.wait     = record.wait;
+       promise.argument = record.argument;
+       promise.wakeTurn = record.wakeTurn;
+       promise.state    = record.state;
+       fileBehaviour(pool, promise);
+   }
+
+   // Waits longer than the wheel come round before their turn.
+   void resumeBehaviour(Behaviour::promise_type& promise)
+   {
+       if(promise.wait == BehaviourWait::TURNS && promise.wakeTurn > turn_)
+       {
+           sleeping_[promise.wakeTurn % BEHAVIOUR_WHEEL].pushBack(promise);
+           return;
+       }
+
+       auto& pool = pools_[static_cast<size_t>(enemyTypeOf(promise.self))];
+       Behaviour& behaviour = pool.behaviours[handleIndexOf(promise.self)];
+       promise.wait = BehaviourWait::NONE;
+       behaviour.resume();
+       pool.version = nextVersion();
+       if(promise.wait == BehaviourWait::DONE)
+       {
+           endBehaviour(pool, behaviour);
+           return;
+       }
+       if(promise.wait == BehaviourWait::TURNS)
+           promise.wakeTurn = turn_ + static_cast<uint64_t>(promise.argument);
+       fileBehaviour(pool, promise);
+   }
+
+   // Only looks around the players, so the cost follows the number
+   // of players and how far the scripts look, not how many wait.
+   void wakeWatchers()
+   {
+       for(auto& pool : pools_)
+       {
+           if(pool.watching == 0)
+               continue;
+
+           int radius = pool.watchRadius;
+           for(auto& player : players_)
+           {
+               position center = player->getPosition();
+               pool.index.forEachInRect(position(center.first - radius, center.second - radius),
+                       limits(2 * radius + 1, 2 * radius + 1), [&](uint32_t slot, position pos) {
+                   Behaviour* behaviour = findBehaviour(pool, slot);
+                   if(!behaviour || behaviour->promise().wait != BehaviourWait::PLAYER)
+                       return true;
+
+                   int distance = max(abs(pos.first - center.first), abs(pos.second - center.second));
+                   if(distance <= behaviour->promise().argument)
+                   {
+                       pool.watching--;
+                       wakeBehaviour(pool, *behaviour);
+                   }
+                   return true;
+               });
+           }
+           if(pool.watching == 0)
+               pool.watchRadius = 0;
+       }
+   }
+
+   // Resumes the scripts whose wait is over, between deciding and
+   // committing so their moves go in with everybody else's.
+   void runBehaviours()
+   {
+       PROFILE_SCOPE(BEHAVIOURS);
+       wakeWatchers();
+
+       // Taken off their lists first, so what they file again
+       // goes on a list that isn't being walked.
+       woken_.moveTo(resuming_);
+       sleeping_[turn_ % BEHAVIOUR_WHEEL].moveTo(resuming_);
+
+       size_t resumed = 0;
+       while(!resuming_.empty())
+       {
+           auto& promise = static_cast<Behaviour::promise_type&>(*resuming_.next);
+           promise.unlink();
+           resumeBehaviour(promise);
+           resumed++;
+       }
+       PROFILE_COUNT(ENTITIES, resumed);
+   }
+
+   // Applied in slot order, so the result is the same however
+   // the decisions were split between threads.
+   template<class Archetype>
+   void commitEnemies(EnemyPool& pool)
+   {
+       auto& store = pool.store;
+       for(size_t i = 0; i < pool.actions.size(); i++)
+       {
+           const EnemyAction& action = pool.actions[i];
+           if(action.player >= 0)
+           {
+               auto& player = players_[action.player];
+               int healthBefore = player->getHealth();
+               player->receiveDamage(store.attack[i]);
+               logEvent(EventKind::DAMAGE, store.ids[i], playerEventId(action.player),
+                       player->getPosition(), position(), healthBefore - player->getHealth(),
+                       player->getHealth());
+
+               position anchor = Archetype::anchor == AttackAnchor::SELF
+                   ? store.positions[i] : player->getPosition();
+               for(auto offset : Archetype::attackOffsets)
+               {
+                   addTurnEffect(Archetype::attackSprite,
+                           position(anchor.first + offset.first, anchor.second + offset.second));
+               }
+           }else if(action.target != store.positions[i])
+           {
+               moveEnemy(pool, i, action.target);
+           }
+       }
+   }
+
+   // Decisions are made on the pool when there is one.
+   void setThreadPool(ThreadPool* pool)
+   {
+       pool_ = pool;
+   }
+
+   // Events go to log from the thread running the turn, which is
+   // the ring's only producer.
+   void setEventLog(EventLog* log)
+   {
+       events_ = log;
+   }
+
+   void logEvent(EventKind kind, EntityId actor, EntityId target, position at,
+           position to = position(), int amount = 0, int left = 0)
+   {
+       if(events_)
+       {
+           events_->push({ turn_, actor, target, at.first, at.second, to.first, to.second,
+                   amount, left, kind, {} });
+       }
+   }
+
+   // Walls are whatever isn't plain ground.
+   bool isPassable(position pos) const
+   {
+       return !collisions_.isBlocked(pos);
+   }
+
+   const CollisionMask& getCollisions() const
+   {
+       return collisions_;
+   }
+
+   void updateFlowField()
+   {
+       PROFILE_SCOPE(FLOW_FIELD);
+       playerPositions_.clear();
+       for(auto& player : players_)
+           playerPositions_.push_back(player->getPosition());
+
+       goalPositions_.clear();
+       forEachArchetype([&](auto archetype) {
+           using Archetype = decltype(archetype);
+           if(Archetype::followsPlayers)
+           {
+               auto& positions = pools_[static_cast<size_t>(Archetype::type)].store.positions;
+               goalPositions_.insert(goalPositions_.end(), positions.begin(), positions.end());
+           }
+       });
+
+       if(flowField_.update(playerPositions_, goalPositions_, worldLimits_,
+               [this](position pos) { return isPassable(pos); }))
+           fieldVersion_ = nextVersion();
+   }
+
+   const FlowField& getFlowField() const
+   {
+       return flowField_;
+   }
+
+   // Every archetype decides in its own loop, then all of them
+   // commit in type order.
+   void EnemiesTurn()
+   {
+       PROFILE_SCOPE(ENEMIES_TURN);
+       PROFILE_COUNT(ENTITIES, getEnemyCount());
+
+       bool followed = false;
+       forEachArchetype([&](auto archetype) {
+           using Archetype = decltype(archetype);
+           if(Archetype::followsPlayers)
+               followed |= pools_[static_cast<size_t>(Archetype::type)].store.size() > 0;
+       });
+       if(followed)
+           updateFlowField();
+
+       {
+           PROFILE_SCOPE(DECIDE);
+           forEachArchetype([&](auto archetype) {
+               using Archetype = decltype(archetype);
+               auto& pool = pools_[static_cast<size_t>(Archetype::type)];
+               pool.actions.resize(pool.store.size());
+
+               auto decide = [&](size_t begin, size_t end) {
+                   decideEnemies<Archetype>(pool, begin, end);
+               };
+               if(pool_)
+                   pool_->parallelFor(pool.store.size(), 4096, decide);
+               else
+                   decide(0, pool.store.size());
+           });
+       }
+
+       runBehaviours();
+
+       {
+           PROFILE_SCOPE(COMMIT);
+           forEachArchetype([&](auto archetype) {
+               using Archetype = decltype(archetype);
+               commitEnemies<Archetype>(pools_[static_cast<size_t>(Archetype::type)]);
+           });
+       }
+       turn_++;
+   }
+
+   Player* getPlayer(size_t playerIndex) const
+   {
+      return players_[playerIndex].get();
+   }
+
+   void clearTerminal()
+   {
+       cout << "\x1B[2J\x1B[H";
+   }
+
+   void setWorldMessage(const string& message)
+   {
+        worldMessage = message;
+   }
+
+   void drawMessages(ostream& out = cout)
+   {
+        PROFILE_SCOPE(DRAW_MESSAGES);
+        out << endl;
+        out << "\tWorld message : " << worldMessage + '\n';
+        out << "\tWorld debug : "  << debugMessage + '\n';
+        out << endl;
+   }
+
+   void setDebugMessage(const string& message) 
+   {
+        debugMessage = message;
+   }
+
+   void clearPlayerAttacks()
+   {
+        for(auto& player : players_)
+            player->clearAttack();
+   }
+    
+};
@@ -0,0 +1,48 @@
+#!/bin/sh
+# Attacks don't reach through walls. A bat sits behind a wall in
+# range of the player's cone and burst, neither may hurt it. With
+# the wall taken out the same attacks must.
+#
+#   tests/attack_shadow.sh [rpg binary]   builds one when none is given
+
+set -u
+cd "$(dirname "$0")/.."
+
+RPG=${1:-}
+if [ -z "$RPG" ]; then
+    build=$(mktemp -d)
+    cmake -S . -B "$build" > /dev/null && cmake --build "$build" -j > /dev/null || exit 1
+    RPG=$build/rpg
+fi
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+cat > "$work/walled.txt" <<'MAP'
+###########
+#J...#.B..#
+###########
+MAP
+sed 's/#\.B/..B/' "$work/walled.txt" > "$work/open.txt"
+printf 'cone right\nburst\ncone right\nburst\n' > "$work/attacks.txt"
+
+failed=0
+hits()
+{
+    "$RPG" --convert-map "$work/$1.txt" "$work/$1.lvl" > /dev/null || exit 1
+    "$RPG" --headless --level "$work/$1.lvl" --seed "$2" --batch "$work/attacks.txt" \
+        --events "$work/events.txt" > /dev/null || exit 1
+    grep -c '^[0-9]* damage player' "$work/events.txt"
+}
+
+for seed in 1 2 3 4 5; do
+    walled=$(hits walled "$seed")
+    open=$(hits open "$seed")
+    if [ "$walled" -ne 0 ] || [ "$open" -eq 0 ]; then
+        echo "FAIL: seed $seed, $walled hits through the wall, $open without it"
+        failed=1
+    fi
+done
+
+[ "$failed" -eq 0 ] && echo "walls shadow attacks"
+exit "$failed"
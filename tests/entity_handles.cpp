@@ -0,0 +1,59 @@
+// Generational enemy handles. A removed enemy's id stops resolving,
+// its handle is handed out again under a new generation, and the
+// enemy swapped into the freed slot is still found by its own id.
+// Nothing in the game spawns after setup, so the store is driven
+// directly here rather than through the command line.
+
+#include "entity_store.h"
+
+int failures = 0;
+
+void check(bool ok, const char* what)
+{
+    if(!ok)
+    {
+        cout << "FAIL: " << what << endl;
+        failures++;
+    }
+}
+
+int main()
+{
+    EntityStore store;
+    store.typeBits = static_cast<EntityId>(ENEMY_TYPE::BLIND_BAT) << ENEMY_ID_TYPE_SHIFT;
+
+    EntityId first  = store.ids[store.add("Blind Bat 1", 20, 10, 10, 'B', position(1, 1))];
+    EntityId second = store.ids[store.add("Blind Bat 2", 20, 10, 10, 'B', position(2, 2))];
+    EntityId third  = store.ids[store.add("Blind Bat 3", 20, 10, 10, 'B', position(3, 3))];
+
+    check(store.remove(store.find(first)) == 2, "the last enemy fills the freed slot");
+    check(store.find(first) == EntityStore::npos, "a removed id stops resolving");
+    check(store.find(third) == 0 && store.positions[0] == position(3, 3), "a moved enemy keeps its id");
+    check(store.find(second) == 1, "an untouched enemy keeps its slot");
+    check(store.getName(0) == "Blind Bat 3", "names follow the id");
+
+    EntityId reused = store.ids[store.add("Blind Bat 4", 20, 10, 10, 'B', position(4, 4))];
+    check(handleIndexOf(reused) == handleIndexOf(first), "the freed handle is reused");
+    check(handleGenerationOf(reused) == handleGenerationOf(first) + 1, "a reused handle gets a new generation");
+    check(store.find(first) == EntityStore::npos, "the old id doesn't resolve to the new enemy");
+    check(store.find(reused) == 2, "the new id resolves");
+
+    // Every handle can be freed and reused without losing track.
+    for(int round = 0; round < 100; round++)
+    {
+        EntityId id = store.ids[store.add(string(), 20, 10, 10, 'B', position(round, round))];
+        store.remove(store.find(id));
+        check(store.find(id) == EntityStore::npos, "an id removed in a loop stops resolving");
+    }
+    check(store.generations.size() == 4, "removal and reuse don't grow the handle table");
+    check(store.find(reused) != EntityStore::npos && store.find(second) != EntityStore::npos
+            && store.find(third) != EntityStore::npos, "the live enemies survive the churn");
+
+    EntityId hound = static_cast<EntityId>(ENEMY_TYPE::HOUND) << ENEMY_ID_TYPE_SHIFT
+        | (reused & ~(static_cast<EntityId>(0xf) << ENEMY_ID_TYPE_SHIFT));
+    check(store.find(hound) == EntityStore::npos, "ids of another type don't resolve");
+
+    if(failures == 0)
+        cout << "handles resolve and reuse as expected" << endl;
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,48 @@
+#!/bin/sh
+# Hounds find the player from anywhere they can reach it. One is
+# just behind a long wall, its way round goes far from the player.
+# Others start across a big open world. The player stands still
+# ("wait" isn't a command) and every hound must get to bite it.
+#
+#   tests/hound_chase.sh [rpg binary]   builds one when none is given
+
+set -u
+cd "$(dirname "$0")/.."
+
+RPG=${1:-}
+if [ -z "$RPG" ]; then
+    build=$(mktemp -d)
+    cmake -S . -B "$build" > /dev/null && cmake --build "$build" -j > /dev/null || exit 1
+    RPG=$build/rpg
+fi
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+{
+    echo '############'
+    echo '#J...#....H#'
+    for i in $(seq 1 56); do echo '#....#.....#'; done
+    echo '#..........#'
+    echo '############'
+} > "$work/wall.txt"
+"$RPG" --convert-map "$work/wall.txt" "$work/wall.lvl" > /dev/null || exit 1
+for i in $(seq 1 400); do echo 'wait'; done > "$work/wait.txt"
+
+failed=0
+bitten()
+{
+    "$RPG" --headless --batch "$work/wait.txt" --events "$work/events.txt" "$@" > /dev/null || exit 1
+    if ! grep -q '^[0-9]* damage H[0-9.]* -> player' "$work/events.txt"; then
+        echo "FAIL: no hound got to the player, $*"
+        failed=1
+    fi
+}
+
+bitten --level "$work/wall.lvl"
+for seed in 1 2 3; do
+    bitten --world 300x300 --hounds 1 --seed "$seed"
+done
+
+[ "$failed" -eq 0 ] && echo "hounds find their way"
+exit "$failed"
@@ -0,0 +1,45 @@
+#!/bin/sh
+# Headless turns must stop allocating after warm up. Checked over
+# several seeds, one seed passing says little, with scripted enemies
+# waking, sleeping and dying, and with a command script using every
+# attack pattern, since the bot only swings.
+#
+#   tests/no_alloc.sh [rpg binary]   builds one when none is given
+
+set -u
+cd "$(dirname "$0")/.."
+
+RPG=${1:-}
+if [ -z "$RPG" ]; then
+    build=$(mktemp -d)
+    cmake -S . -B "$build" > /dev/null && cmake --build "$build" -j > /dev/null || exit 1
+    RPG=$build/rpg
+fi
+
+failed=0
+run()
+{
+    if ! "$RPG" --headless "$@" --assert-no-alloc > /dev/null; then
+        echo "FAIL: $*"
+        failed=1
+    fi
+}
+
+for seed in 1 2 3 4 5 6 7 8 9 10; do
+    run --turns 500 --seed "$seed"
+    run --turns 500 --seed "$seed" --enemies 200 --hounds 40 --world 48x48
+    run --turns 500 --seed "$seed" --swoopers 60 --guards 60 --world 48x48
+done
+
+script=$(mktemp)
+for i in $(seq 1 100); do
+    printf 'cone up\nburst\nright\ncone left\nattack down\nleft\n'
+done > "$script"
+for seed in 1 2 3; do
+    run --batch "$script" --seed "$seed" --enemies 300 --hounds 30 --world 32x32
+    run --batch "$script" --seed "$seed" --swoopers 40 --guards 40 --world 32x32
+done
+rm -f "$script"
+
+[ "$failed" -eq 0 ] && echo "no allocations after warm up"
+exit "$failed"
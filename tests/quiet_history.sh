@@ -0,0 +1,49 @@
+#!/bin/sh
+# Keeping a turn for undo only writes what changed during it. With
+# the player waiting and every guard asleep, a turn writes close to
+# nothing next to a whole snapshot, however many guards there are.
+# Undo still goes back exactly over such turns.
+#
+#   tests/quiet_history.sh [rpg binary]   builds one when none is given
+
+set -u
+cd "$(dirname "$0")/.."
+
+RPG=${1:-}
+if [ -z "$RPG" ]; then
+    build=$(mktemp -d)
+    cmake -S . -B "$build" > /dev/null && cmake --build "$build" -j > /dev/null || exit 1
+    RPG=$build/rpg
+fi
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+# Open ground, the player in the middle and nothing else.
+awk 'BEGIN { for(r = 0; r < 128; r++) { line = ""; for(c = 0; c < 128; c++) line = line (r == 64 && c == 64 ? "J" : "."); print line } }' \
+    > "$work/map.txt"
+"$RPG" --convert-map "$work/map.txt" "$work/map.lvl" > /dev/null || exit 1
+for i in $(seq 1 100); do echo wait; done > "$work/waits.txt"
+
+failed=0
+for guards in 1000 4000; do
+    set -- --headless --level "$work/map.lvl" --guards "$guards" --seed 1
+    whole=$("$RPG" "$@" --history 1 --batch "$work/waits.txt" | sed -n 's/^undo history.*(\([0-9]*\) bytes\/turn.*/\1/p')
+    quiet=$("$RPG" "$@" --history 100 --batch "$work/waits.txt" | sed -n 's/.*, \([0-9]*\) written last turn.*/\1/p')
+    if [ -z "$whole" ] || [ -z "$quiet" ] || [ "$quiet" -gt 256 ] || [ $((quiet * 1000)) -gt "$whole" ]; then
+        echo "FAIL: $guards guards, a quiet turn wrote ${quiet:-?} bytes, a whole snapshot is ${whole:-?}"
+        failed=1
+    fi
+
+    { cat "$work/waits.txt"; echo "undo 50"; } > "$work/undone.txt"
+    head -n 50 "$work/waits.txt" > "$work/half.txt"
+    undone=$("$RPG" "$@" --history 100 --batch "$work/undone.txt" | grep '^state hash')
+    half=$("$RPG" "$@" --history 100 --batch "$work/half.txt" | grep '^state hash')
+    if [ -z "$half" ] || [ "$undone" != "$half" ]; then
+        echo "FAIL: $guards guards, undo over quiet turns : $undone / $half"
+        failed=1
+    fi
+done
+
+[ "$failed" -eq 0 ] && echo "quiet turns cost next to nothing to keep"
+exit "$failed"
@@ -0,0 +1,44 @@
+#!/bin/sh
+# Rooms on the work stealing pool. Every room slot plays exactly the
+# turns it was given whatever the thread count, closed rooms are
+# replaced, and the same seed opens the same rooms.
+#
+#   tests/rooms.sh [rpg binary]   builds one when none is given
+
+set -u
+cd "$(dirname "$0")/.."
+
+RPG=${1:-}
+if [ -z "$RPG" ]; then
+    build=$(mktemp -d)
+    cmake -S . -B "$build" > /dev/null && cmake --build "$build" -j > /dev/null || exit 1
+    RPG=$build/rpg
+fi
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+failed=0
+for threads in 1 4; do
+    out=$("$RPG" --rooms 40 --rounds 150 --room-turns 50 --threads "$threads" --seed 3 \
+        --room-stats "$work/rooms$threads.csv") || { echo "FAIL: $threads threads, rooms didn't run"; failed=1; continue; }
+    turns=$(echo "$out" | sed -n 's/^room turns *: \([0-9]*\)$/\1/p')
+    closed=$(echo "$out" | sed -n 's/^rooms .* \([0-9]*\) closed$/\1/p')
+    if [ "${turns:-0}" -ne 6000 ] || [ "${closed:-0}" -eq 0 ]; then
+        echo "FAIL: $threads threads, ${turns:-?} turns played, ${closed:-?} rooms closed"
+        failed=1
+    fi
+done
+
+# Which room a slot opens, and how long it lives, doesn't depend on
+# the threads, only the timings do.
+for threads in 1 4; do
+    cut -d, -f1-3 "$work/rooms$threads.csv" > "$work/rooms$threads.ids"
+done
+if ! cmp -s "$work/rooms1.ids" "$work/rooms4.ids"; then
+    echo "FAIL: 1 and 4 threads opened different rooms"
+    failed=1
+fi
+
+[ "$failed" -eq 0 ] && echo "every room slot played its turns"
+exit "$failed"
@@ -0,0 +1,53 @@
+#!/bin/sh
+# Walls block the player. A corridor is walked past its end, the
+# player tries to step into the walls around it, then goes down
+# through the one gap and along the corridor below.
+#
+#   tests/walls.sh [rpg binary]   builds one when none is given
+
+set -u
+cd "$(dirname "$0")/.."
+
+RPG=${1:-}
+if [ -z "$RPG" ]; then
+    build=$(mktemp -d)
+    cmake -S . -B "$build" > /dev/null && cmake --build "$build" -j > /dev/null || exit 1
+    RPG=$build/rpg
+fi
+
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+cat > "$work/map.txt" <<'MAP'
+##########################################
+#J.......................................#
+#####################################.####
+#........................................#
+##########################################
+MAP
+"$RPG" --convert-map "$work/map.txt" "$work/map.lvl" > /dev/null || exit 1
+
+failed=0
+walk()
+{
+    expected=$1
+    shift
+    for step in "$@"; do echo "$step"; done > "$work/walk.txt"
+    at=$("$RPG" --headless --level "$work/map.lvl" --batch "$work/walk.txt" | grep '^player at')
+    if [ "$at" != "player at     : $expected" ]; then
+        echo "FAIL: expected $expected after $*, got $at"
+        failed=1
+    fi
+}
+
+rights=$(for i in $(seq 1 60); do printf 'right '; done)
+lefts=$(for i in $(seq 1 60); do printf 'left '; done)
+
+walk "1, 1" up left down
+walk "1, 40" $rights
+walk "1, 40" $rights up down
+walk "3, 37" $rights left left left down down down
+walk "3, 1" $rights left left left down down $lefts up
+
+[ "$failed" -eq 0 ] && echo "walls stop the player"
+exit "$failed"
@@ -0,0 +1,110 @@
+// The room pool's deque and parking. Every item pushed onto a deque
+// comes out exactly once however many threads steal it, growth
+// included, and recurring tasks run exactly as often as they push
+// themselves, with run() only returning once they're all done. With
+// one core the threads mostly take turns, the checks still hold.
+
+#include "work_stealing_pool.h"
+
+int failures = 0;
+
+void check(bool ok, const char* what)
+{
+    if(!ok)
+    {
+        cout << "FAIL: " << what << endl;
+        failures++;
+    }
+}
+
+struct Recurring
+{
+    WorkStealingPool::Task task;
+    WorkStealingPool* pool;
+    atomic<long> runs {0};
+    long left = 0;
+};
+
+void recur(void* context, size_t worker)
+{
+    Recurring& recurring = *static_cast<Recurring*>(context);
+    recurring.runs.fetch_add(1, memory_order_relaxed);
+    if(--recurring.left > 0)
+        recurring.pool->push(worker, recurring.task);
+}
+
+int main()
+{
+    // The owner pushes past the starting ring while three thieves
+    // take from the other end.
+    {
+        constexpr size_t ITEMS = 200000;
+        vector<long> items(ITEMS);
+        vector< atomic<int> > taken(ITEMS);
+        TaskDeque<long*> deque(4);
+        atomic<bool> pushed {false};
+
+        auto thief = [&] {
+            for(;;)
+            {
+                bool done = pushed.load();
+                if(long* item = deque.steal())
+                    taken[item - items.data()].fetch_add(1);
+                else if(done && deque.empty())
+                    return;
+            }
+        };
+        vector<thread> thieves;
+        for(int i = 0; i < 3; i++)
+            thieves.emplace_back(thief);
+        for(size_t i = 0; i < ITEMS; i++)
+        {
+            deque.push(&items[i]);
+            if(i % 7 == 0)
+            {
+                if(long* item = deque.steal())
+                    taken[item - items.data()].fetch_add(1);
+            }
+        }
+        pushed.store(true);
+        for(auto& t : thieves)
+            t.join();
+
+        bool once = true;
+        for(auto& count : taken)
+            once = once && count.load() == 1;
+        check(once, "every pushed item is taken exactly once");
+        check(deque.steal() == nullptr, "an emptied deque gives nothing");
+    }
+
+    // Tasks that push themselves again, on a pool run more than once
+    // so its threads park in between.
+    for(size_t threads : { 1, 2, 4 })
+    {
+        WorkStealingPool pool(threads);
+        vector<Recurring> tasks(64);
+        for(int round = 0; round < 3; round++)
+        {
+            for(size_t i = 0; i < tasks.size(); i++)
+            {
+                tasks[i].task = { &recur, &tasks[i] };
+                tasks[i].pool = &pool;
+                tasks[i].runs = 0;
+                tasks[i].left = 100 + static_cast<long>(i);
+                pool.submit(tasks[i].task);
+            }
+            pool.run();
+
+            bool exact = true;
+            for(size_t i = 0; i < tasks.size(); i++)
+                exact = exact && tasks[i].runs.load() == 100 + static_cast<long>(i);
+            check(exact, "recurring tasks run as often as they push themselves");
+        }
+        // Nothing pushed, returns straight away.
+        pool.run();
+    }
+
+    if(failures == 0)
+        cout << "the pool runs every task exactly once" << endl;
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}